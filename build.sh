@@ -16,6 +16,20 @@ if [ ! -d ${ADDR}/ApproxLatCount/ ]; then
 	mv ${ADDR}/ApproxLatCount/ApproxLatCount ${ADDR}/bin/.
 fi
 
+#Vinci
+echo "Checking and compiling Vinci"
+#the sources are patched for sharpSMT, a stale extraction is replaced 
+#whenever the zip is newer than it
+if [ ! -f ${ADDR}/vinci-1.0.5/.extracted ] || [ ${ADDR}/vinci-1.0.5.zip -nt ${ADDR}/vinci-1.0.5/.extracted ]; then
+	rm -rf ${ADDR}/vinci-1.0.5
+	unzip -q ${ADDR}/vinci-1.0.5.zip -d ${ADDR}
+	touch ${ADDR}/vinci-1.0.5/.extracted
+fi
+cd ${ADDR}/vinci-1.0.5
+make vinci libvinci.a
+cd ../
+cp ${ADDR}/vinci-1.0.5/vinci ${ADDR}/bin/.
+
 #volce main program
 echo "Compiling sharpSMT ..."
 cd ${ADDR}
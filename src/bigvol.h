@@ -0,0 +1,80 @@
+/*  bigvol.h
+ *
+ *  Copyright (C) 2016-2024 Cunjing Ge.
+ *
+ *  All rights reserved.
+ *
+ *  This file is part of sharpSMT.
+ *  See COPYING for more information on using this software.
+ */
+
+#include <global.h>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+#ifndef BIGVOL_HEADER
+#define BIGVOL_HEADER
+
+namespace volce {
+
+// real number m * 2^e with a double mantissa m in [0.5, 1) and a long exponent,
+// volumes of large boxes, e.g., 2^(wordlength * nVars), neither overflow nor underflow
+class bigvol {
+public:
+	bigvol() : m(0), e(0) {};
+	bigvol(const double v) { int k; m = frexp(v, &k); e = k; };
+	~bigvol() {};
+
+	// 2^n
+	static const bigvol pow2(const long n) { bigvol r; r.m = 0.5; r.e = n + 1; return r; };
+
+	const bigvol operator*(const bigvol &b) const { return make(m * b.m, e + b.e); };
+	const bigvol operator/(const bigvol &b) const { return make(m / b.m, e - b.e); };
+	const bigvol operator+(const bigvol &b) const {
+		if (m == 0) return b;
+		if (b.m == 0) return *this;
+		//the smaller one vanishes beyond the precision of double
+		if (e - b.e > 64) return *this;
+		if (b.e - e > 64) return b;
+		if (e >= b.e) return make(m + ldexp(b.m, (int)(b.e - e)), e);
+		else return make(ldexp(m, (int)(e - b.e)) + b.m, b.e); };
+	bigvol &operator+=(const bigvol &b) { return *this = *this + b; };
+	bigvol &operator*=(const bigvol &b) { return *this = *this * b; };
+
+	const bool operator==(const bigvol &b) const { return m == b.m && e == b.e; };
+	const bool operator!=(const bigvol &b) const { return !(*this == b); };
+	const bool operator<(const bigvol &b) const {
+		if ((m < 0) != (b.m < 0) || m == 0 || b.m == 0) return m < b.m;
+		if (e != b.e) return (m > 0) ? e < b.e : e > b.e;
+		return m < b.m; };
+
+	// inf or 0 out of the range of double
+	const double get_d() const {
+		if (e > std::numeric_limits<int>::max()) return (m > 0) ? HUGE_VAL : -HUGE_VAL;
+		if (e < std::numeric_limits<int>::min()) return 0;
+		return ldexp(m, (int)e); };
+
+	//printed as a double within its range, otherwise as <mantissa>e<exponent> in decimal
+	friend std::ostream &operator<<(std::ostream &os, const bigvol &v) {
+		if (v.m == 0 || (v.e > -1000 && v.e < 1000)) return os << v.get_d();
+		double lg = log10(fabs(v.m)) + v.e * log10(2.0);
+		double ex = floor(lg);
+		std::ostringstream s;
+		s.precision(os.precision());
+		s << ((v.m < 0) ? "-" : "") << pow(10, lg - ex) << 'e' << ((ex < 0) ? '-' : '+') << (long)fabs(ex);
+		return os << s.str(); };
+
+private:
+	double	m;
+	long	e;
+
+	static const bigvol make(const double mant, const long ex) {
+		bigvol r(mant);
+		if (r.m != 0) r.e += ex;
+		return r; };
+};
+
+}
+
+#endif
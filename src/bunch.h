@@ -0,0 +1,115 @@
+/*  bunch.h
+ *
+ *  Copyright (C) 2016-2024 Cunjing Ge.
+ *
+ *  All rights reserved.
+ *
+ *  This file is part of sharpSMT.
+ *  See COPYING for more information on using this software.
+ */
+
+#include <global.h>
+#include <cstdint>
+
+#ifndef BUNCH_HEADER
+#define BUNCH_HEADER
+
+namespace volce {
+
+// partial assignment of literals, each literal takes two bits:
+// a known bit and a value bit, stored as known words then value words
+// literal values are 1 (true), 0 (false) and -1 (unknown)
+class bsol {
+public:
+	bsol() : n(0), nw(0) {};
+	bsol(const unsigned int nlits) : n(nlits), nw(nwords(nlits)), w(2 * nw, 0) {};
+	bsol(const unsigned int nlits, const uint64_t *k, const uint64_t *v) :
+		n(nlits), nw(nwords(nlits)), w(k, k + nw) {
+		w.insert(w.end(), v, v + nw);
+		// clear bits beyond n
+		if (n % 64 != 0) {
+			uint64_t mask = ((uint64_t)1 << (n % 64)) - 1;
+			w[nw - 1] &= mask;
+			w[2 * nw - 1] &= mask;
+		}
+	};
+	~bsol() {};
+
+	static const unsigned int nwords(const unsigned int nlits) { return (nlits + 63) / 64; };
+
+	//get & set value
+	const int operator[](const unsigned int i) const {
+		if (!((w[i / 64] >> (i % 64)) & 1)) return -1;
+		return (w[nw + i / 64] >> (i % 64)) & 1; };
+	void set(const unsigned int i, const int val) {
+		uint64_t bit = (uint64_t)1 << (i % 64);
+		w[i / 64] &= ~bit; w[nw + i / 64] &= ~bit;
+		if (val >= 0) w[i / 64] |= bit;
+		if (val > 0) w[nw + i / 64] |= bit; };
+
+	//packed words
+	const unsigned int size() const { return n; };
+	const unsigned int nwords() const { return nw; };
+	uint64_t *known() { return w.data(); };
+	uint64_t *value() { return w.data() + nw; };
+	const uint64_t *known() const { return w.data(); };
+	const uint64_t *value() const { return w.data() + nw; };
+	const std::vector<uint64_t> &words() const { return w; };
+
+	//the number of known literals
+	const unsigned int count() const {
+		unsigned int c = 0;
+		for (unsigned int i = 0; i < nw; i++) c += __builtin_popcountll(w[i]);
+		return c; };
+
+	//key of maps
+	const bool operator<(const bsol &b) const { return w < b.w; };
+	const bool operator==(const bsol &b) const { return w == b.w; };
+
+private:
+	unsigned int n;
+	unsigned int nw;
+	std::vector<uint64_t> w;
+};
+
+// store of bunches, all in a contiguous arena with 2 * nwords words per bunch
+class bunch_store {
+public:
+	bunch_store() : n(0), nw(0), cnt(0) {};
+	~bunch_store() {};
+
+	void init(const unsigned int nlits) { n = nlits; nw = bsol::nwords(nlits); cnt = 0; arena.clear(); };
+
+	void push_back(const bsol &b) {
+		assert(b.size() == n);
+		arena.insert(arena.end(), b.words().begin(), b.words().end());
+		cnt++; };
+
+	const unsigned int size() const { return cnt; };
+	const unsigned int nlits() const { return n; };
+	const unsigned int nwords() const { return nw; };
+
+	//packed words of a bunch
+	const uint64_t *known(const unsigned int index) const { return arena.data() + 2 * nw * index; };
+	const uint64_t *value(const unsigned int index) const { return arena.data() + 2 * nw * index + nw; };
+
+	const bool is_known(const unsigned int index, const unsigned int i) const {
+		return (known(index)[i / 64] >> (i % 64)) & 1; };
+	const bool is_true(const unsigned int index, const unsigned int i) const {
+		return (value(index)[i / 64] >> (i % 64)) & 1; };
+
+	//the first m literals of a bunch
+	const bsol get(const unsigned int index, const unsigned int m) const {
+		assert(m <= n);
+		return bsol(m, known(index), value(index)); };
+
+private:
+	unsigned int n;
+	unsigned int nw;
+	unsigned int cnt;
+	std::vector<uint64_t> arena;
+};
+
+}
+
+#endif
@@ -0,0 +1,159 @@
+/*  cache.cpp
+ *
+ *  Copyright (C) 2016-2024 Cunjing Ge.
+ *
+ *  All rights reserved.
+ *
+ *  This file is part of sharpSMT.
+ *  See COPYING for more information on using this software.
+ */
+
+#include "cache.h"
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+
+static const char CACHE_MAGIC[8] = {'S', 'S', 'M', 'T', 'V', 'C', '0', '3'};
+
+const uint64_t volce::vol_cache::DEFAULT_CAPACITY;
+const unsigned int volce::vol_cache::VAL_LEN;
+
+const bool volce::vol_cache::open(const std::string filename, const uint64_t capacity) {
+
+	close();
+
+	fd = ::open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+	if (fd < 0) return false;
+
+	//initialize a new file, only one process can do it
+	flock(fd, LOCK_EX);
+
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		flock(fd, LOCK_UN);
+		close();
+		return false;
+	}
+
+	if (st.st_size == 0) {
+		cap = capacity;
+		len = sizeof(header) + cap * sizeof(entry);
+		header h;
+		memcpy(h.magic, CACHE_MAGIC, sizeof(h.magic));
+		h.capacity = cap;
+		h.count = 0;
+		//the file is sparse, empty slots are zeros
+		if (ftruncate(fd, len) != 0 || pwrite(fd, &h, sizeof(h), 0) != sizeof(h)) {
+			flock(fd, LOCK_UN);
+			close();
+			return false;
+		}
+	} else {
+		header h;
+		if (pread(fd, &h, sizeof(h), 0) != sizeof(h) ||
+			memcmp(h.magic, CACHE_MAGIC, sizeof(h.magic)) != 0 ||
+			(uint64_t)st.st_size != sizeof(header) + h.capacity * sizeof(entry)) {
+			//not a cache file
+			flock(fd, LOCK_UN);
+			close();
+			return false;
+		}
+		cap = h.capacity;
+		len = st.st_size;
+	}
+
+	flock(fd, LOCK_UN);
+
+	base = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (base == MAP_FAILED) {
+		base = NULL;
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void volce::vol_cache::close() {
+	if (base != NULL) munmap(base, len);
+	if (fd >= 0) ::close(fd);
+	base = NULL;
+	fd = -1;
+	len = 0;
+	cap = 0;
+}
+
+volce::vol_cache::entry *volce::vol_cache::probe(const key128 &key) {
+
+	//linear probing, the table is never full
+	entry *s = slots();
+	for (uint64_t i = key.w[0] % cap; ; i = (i + 1) % cap) {
+		if (s[i].key == key || s[i].key.empty())
+			return &s[i];
+	}
+}
+
+const bool volce::vol_cache::find_text(const key128 &key, std::string &val) {
+
+	if (!is_open()) return false;
+
+	std::lock_guard<std::mutex> lock(mtx);
+	flock(fd, LOCK_SH);
+	entry *e = probe(key);
+	bool found = (e->key == key);
+	if (found) val.assign(e->val, strnlen(e->val, VAL_LEN));
+	flock(fd, LOCK_UN);
+
+	return found;
+}
+
+void volce::vol_cache::insert_text(const key128 &key, const std::string &val) {
+
+	//values too long for a slot are not kept
+	if (!is_open() || val.size() >= VAL_LEN) return;
+
+	std::lock_guard<std::mutex> lock(mtx);
+	flock(fd, LOCK_EX);
+	entry *e = probe(key);
+	if (e->key.empty() && head()->count < cap / 4 * 3) {
+		//new entry
+		memcpy(e->val, val.c_str(), val.size() + 1);
+		e->key = key;
+		head()->count++;
+	}
+	flock(fd, LOCK_UN);
+}
+
+const bool volce::vol_cache::find(const key128 &key, double &val) {
+	std::string text;
+	if (!find_text(key, text) || text.empty()) return false;
+	//a damaged entry is a miss
+	char *end;
+	double v = strtod(text.c_str(), &end);
+	if (*end != '\0' || !std::isfinite(v)) return false;
+	val = v;
+	return true;
+}
+
+void volce::vol_cache::insert(const key128 &key, const double val) {
+	//17 digits are enough to read the same double back
+	char text[VAL_LEN];
+	snprintf(text, sizeof(text), "%.17g", val);
+	insert_text(key, text);
+}
+
+const bool volce::vol_cache::find(const key128 &key, rational &val) {
+	std::string text;
+	//a damaged entry is a miss
+	return find_text(key, text) && rational::parse(text, val);
+}
+
+void volce::vol_cache::insert(const key128 &key, const rational &val) {
+	insert_text(key, val.str());
+}
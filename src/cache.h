@@ -0,0 +1,120 @@
+/*  cache.h
+ *
+ *  Copyright (C) 2016-2024 Cunjing Ge.
+ *
+ *  All rights reserved.
+ *
+ *  This file is part of sharpSMT.
+ *  See COPYING for more information on using this software.
+ */
+
+#include <global.h>
+#include <rational.h>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+
+#ifndef CACHE_HEADER
+#define CACHE_HEADER
+
+namespace volce {
+
+// 128-bit key of a system, all zero is reserved for empty slots
+struct key128 {
+	uint64_t w[2];
+	
+	const bool operator==(const key128 &k) const { return w[0] == k.w[0] && w[1] == k.w[1]; };
+	const bool empty() const { return w[0] == 0 && w[1] == 0; };
+};
+
+struct key128_hash {
+	size_t operator()(const key128 &k) const { return (size_t)k.w[0]; };
+};
+
+// persistent cache of results, a hash table in a memory-mapped file
+// the table has a fixed capacity and stops accepting new entries once it is 3/4 full
+// it can be shared by threads and by concurrent processes
+// values are kept as text, doubles round-trip and exact counts are kept if they fit
+class vol_cache {
+public:
+	vol_cache() : fd(-1), base(NULL), len(0), cap(0) {};
+	~vol_cache() { close(); };
+
+	const bool open(const std::string filename, const uint64_t capacity = DEFAULT_CAPACITY);
+	void close();
+	const bool is_open() const { return base != NULL; };
+
+	const bool find(const key128 &key, double &val);
+	void insert(const key128 &key, const double val);
+	const bool find(const key128 &key, rational &val);
+	void insert(const key128 &key, const rational &val);
+
+	static const uint64_t DEFAULT_CAPACITY = 1 << 20;
+	static const unsigned int VAL_LEN = 48;
+
+private:
+	struct header {
+		char		magic[8];
+		uint64_t	capacity;
+		uint64_t	count;
+	};
+	struct entry {
+		key128		key;
+		char		val[VAL_LEN];	// zero terminated
+	};
+
+	int			fd;
+	void		*base;
+	size_t		len;
+	uint64_t	cap;
+	std::mutex	mtx;		// threads of this process
+
+	header *head() { return (header *)base; };
+	entry *slots() { return (entry *)((char *)base + sizeof(header)); };
+
+	//slot of the key, or the empty slot to put it
+	entry *probe(const key128 &key);
+	
+	const bool find_text(const key128 &key, std::string &val);
+	void insert_text(const key128 &key, const std::string &val);
+};
+
+// 128-bit hash of a sequence of words
+class hash128 {
+public:
+	hash128() : h0(0x9e3779b97f4a7c15ULL), h1(0xc2b2ae3d27d4eb4fULL) {};
+
+	void add(const uint64_t v) {
+		h0 = mix(h0 ^ v);
+		h1 = mix(h1 + v * 0xff51afd7ed558ccdULL); };
+	void add(const double v) {
+		// -0.0 and 0.0 are the same value
+		double d = (v == 0) ? 0 : v;
+		uint64_t u; memcpy(&u, &d, sizeof(u));
+		add(u); };
+	void add(const std::string &s) {
+		// the length keeps the words of different strings apart
+		add((uint64_t)s.size());
+		for (size_t i = 0; i < s.size(); i += 8) {
+			uint64_t u = 0;
+			memcpy(&u, s.data() + i, std::min((size_t)8, s.size() - i));
+			add(u);
+		} };
+
+	const key128 get() const {
+		key128 key = {{h0, h1}};
+		if (key.empty()) key.w[1] = 1;
+		return key; };
+
+private:
+	uint64_t h0, h1;
+
+	static uint64_t mix(uint64_t x) {
+		x ^= x >> 33; x *= 0xff51afd7ed558ccdULL;
+		x ^= x >> 33; x *= 0xc4ceb9fe1a85ec53ULL;
+		x ^= x >> 33; return x; };
+};
+
+}
+
+#endif
@@ -11,6 +11,7 @@
 
 
 #include <solver.h>
+#include <sstream>
 
 void volce::solver::err_all(const ERROR_TYPE e, const std::string s, const unsigned int ln) const {
 
@@ -142,10 +143,15 @@ void volce::solver::err_zero_divisor(const unsigned int ln) const {
 
 
 //global errors
+//raised by the workers, thrown to the pool and reported by the main thread
 //cannot open file
 void volce::solver::err_open_file(const std::string filename) const {
-	std::cout << "error: Cannot open file \"" << filename << "\"." << std::endl;
-	exit(0);
+	throw global_error("error: Cannot open file \"" + filename + "\".\n", 0);
+}
+
+//cannot create directory
+void volce::solver::err_make_dir(const std::string dirname) const {
+	throw global_error("error: Cannot create directory \"" + dirname + "\".\n", 0);
 }
 
 //error while adding new constraints
@@ -156,11 +162,23 @@ void volce::solver::err_solving_initialized() const {
 
 //unbounded polytope
 void volce::solver::err_unbounded_polytope() const {
-	std::cout << "\nThe problem is unbounded.\n\n";
-	std::cout << "Hint: VolCE provides wordlength parameter (-w) to quickly set bound \n"
-			  << "      to each variable with bit-wise domain. For details, check the \n"
-			  << "      help menu with '-h' or '--help'.\n";
-	exit(1);
+	std::ostringstream msg;
+	msg << "\nThe problem is unbounded.\n\n";
+	msg << "Hint: VolCE provides wordlength parameter (-w) to quickly set bound \n"
+		<< "      to each variable with bit-wise domain. For details, check the \n"
+		<< "      help menu with '-h' or '--help'.\n";
+	throw global_error(msg.str(), 1);
+}
+
+//too many facets for the revised lasserre scheme of vinci
+void volce::solver::err_vinci_planes(const unsigned int nplanes) const {
+	throw global_error("error: Vinci cannot compute the volume of a polytope with " 
+		+ std::to_string(nplanes) + " hyperplanes, at most 254 are supported.\n", 0);
+}
+
+//an external tool failed or gave no result
+void volce::solver::err_tool_failed(const std::string tool) const {
+	throw global_error("error: " + tool + " failed to compute a result.\n", 0);
 }
 
 //logic not support latte
@@ -192,3 +210,7 @@ void volce::solver::warn_cmd_nsup(const std::string nm, const unsigned int ln) c
 	//std::cout << "warning: \"" << nm << "\" command is safely ignored in line " << ln << "." << std::endl;
 }
 
+//cache file cannot be used, results are not cached
+void volce::solver::warn_open_cache(const std::string filename) const {
+	std::cout << "warning: Cannot open cache file \"" << filename << "\", results are not cached." << std::endl;
+}
@@ -11,11 +11,11 @@
 
 #include <ineq.h>
 
-const std::vector<double> volce::ineqc::get_key() const {
+const std::vector<volce::rational> volce::ineqc::get_key() const {
 
-	std::vector<double> key{(double)eq, cst};
+	std::vector<rational> key{(int)eq, cst};
 	for (unsigned int i = 0; i < tm.size(); i++){
-		key.push_back(tm[i].id);
+		key.push_back((long)tm[i].id);
 		key.push_back(tm[i].m);
 	}
 	return key;
@@ -10,6 +10,7 @@
 
 
 #include <global.h>
+#include "rational.h"
 
 
 #ifndef INEQ_HEADER
@@ -21,10 +22,10 @@ class term{
 public:
 	//<index, multiplier>
 	unsigned int 	id;
-	double 			m;
+	rational 		m;
 	
 	term() : id(0), m(1) {};
-	term(const unsigned int index, const double multiplier) : id(index), m(multiplier) {};
+	term(const unsigned int index, const rational multiplier) : id(index), m(multiplier) {};
 	~term(){};
 	
 	// terms order
@@ -38,20 +39,20 @@ private:
 class ineqc{
 public:
 	
-	ineqc(const bool isequality, const double constant, std::vector<term> &terms) :
+	ineqc(const bool isequality, const rational constant, std::vector<term> &terms) :
 			eq(isequality), cst(constant), tm(terms) { unify(); };
 	~ineqc(){};
 	
 	const bool iseq() const { return eq; };
 	const bool isle() const { return !eq; };
 	
-	const double get_const() const { return cst; };
-	const double get_const_r() const { return -cst; };
+	const rational get_const() const { return cst; };
+	const rational get_const_r() const { return -cst; };
 	
-	const term operator[](unsigned int index) const { return tm[index]; };
+	const term &operator[](unsigned int index) const { return tm[index]; };
 	const unsigned int size() const { return tm.size(); };
 	
-	const std::vector<double> get_key() const;
+	const std::vector<rational> get_key() const;
 	
 	// sort & merge and keep the first term positive
 	void unify();
@@ -60,7 +61,7 @@ private:
 
 	// <const> + <term_0> + <term_1> + ... = (<=) 0
 	bool eq;
-	double cst;
+	rational cst;
 	std::vector<term> tm;
 	
 	//sort and merge same id terms
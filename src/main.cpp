@@ -8,8 +8,10 @@
  *  See COPYING for more information on using this software.
  */
 
+#include <atomic>
 #include <chrono>
 #include <solver.h>
+#include <pool.h>
 
 #define MAX_DIRSTR_SIZE 255
 
@@ -45,14 +47,43 @@ void printUsage(char* exec_name){
 //    cout << endl;
 	cout << "  -bunch={0,1}\t   Enable (1) or disable (0) the Bunch strategy. This " << endl;
 	cout << "              \t   strategy is enabled by default." << endl;
+    cout << endl;
+	cout << "  -prime={0,1}\t   Enable (1) or disable (0) the reduction of bunches to" << endl;
+	cout << "              \t   prime implicants by Z3, which gives fewer and larger " << endl;
+	cout << "              \t   bunches at the cost of more Z3 calls. By default, it " << endl;
+	cout << "              \t   is disabled." << endl;
     cout << endl;
 	cout << "  -fact={0,1} \t   Enable (1) or disable (0) the factorization strategy." << endl;
 	cout << "              \t   It can be very efficient for problems whose variables " << endl;
 	cout << "              \t   are less connective. By default, this strategy is en-" << endl;
 	cout << "              \t   abled. " << endl;
+    cout << endl;
+	cout << "  -comp={0,1} \t   Enable (1) or disable (0) the decomposition of formu-" << endl;
+	cout << "              \t   las into independent components, whose bunches are " << endl;
+	cout << "              \t   enumerated separately. PolyVest samples more points " << endl;
+	cout << "              \t   for each of the components, since the total volume is " << endl;
+	cout << "              \t   their product. The total count of ALC is a product " << endl;
+	cout << "              \t   of estimates, and their errors add up. By default, it" << endl;
+	cout << "              \t   is enabled." << endl;
     cout << endl;
 	cout << "  -ge={0,1}   \t   Enable (1) or disable (0) the Gauss elimination. By" << endl;
 	cout << "              \t   default, this strategy is enabled." << endl;
+    cout << endl;
+	cout << "  -j={1,2,...}\t   The number of threads that compute bunches in paral-" << endl;
+	cout << "              \t   lel, while Z3 keeps enumerating bunches. The default" << endl;
+	cout << "              \t   value is 1." << endl;
+    cout << endl;
+	cout << "  -ej={1,2,...}\t   The number of threads that enumerate bunches in pa-" << endl;
+	cout << "              \t   rallel, each on its own cubes of the formula with its" << endl;
+	cout << "              \t   own Z3 context. There are about 2 cubes for each " << endl;
+	cout << "              \t   thread. Bunches do not span cubes, so a component may" << endl;
+	cout << "              \t   get up to as many times more bunches as it has cubes," << endl;
+	cout << "              \t   and so more volume or counting calls. The default " << endl;
+	cout << "              \t   value is 1." << endl;
+    cout << endl;
+	cout << "  -cache={dir}\t   Keep the results of volume and counting routines in " << endl;
+	cout << "              \t   files under dir, and reuse them in later runs. By " << endl;
+	cout << "              \t   default, it is disabled." << endl;
     cout << endl;
 	cout << "  -verb={0,1} \t   The verbosity of output. Positive value will enable " << endl;
 	cout << "              \t   pretty print. Otherwise, only print the final result. " << endl;
@@ -65,6 +96,10 @@ void printUsage(char* exec_name){
     cout << endl;
     cout << "  -delta={real}\t   Delta should be a real in (0, 1) that works with ep- " <<endl;
     cout << "              \t   silon together. The default value is 0.1." << endl;
+    cout << endl;
+	cout << "  -seed={0,1,...}  Seed of the random walks of PolyVest. A positive seed" << endl;
+	cout << "              \t   makes the estimates reproducible. By default, it is " << endl;
+	cout << "              \t   0, which seeds by the time." << endl;
     cout << endl;
     cout << "INPUT-FILE:" << endl;
     cout << "  .smt2       \t   SMT-LIBv2 language input." << endl;
@@ -73,12 +108,31 @@ void printUsage(char* exec_name){
 }
 
 // calculate the coefficient for two-round strategy
-double cal_coef(double vol, double mvol, double minc, double maxc){
-	double t = 2 * maxc * vol / mvol;
+double cal_coef(volce::bigvol vol, volce::bigvol mvol, double minc, double maxc){
+	double t = 2 * maxc * (vol / mvol).get_d();
 	t = (t <= minc) ? minc : (t > maxc) ? maxc : t;
 	return t;
 }
 
+// components are independent, the total is the product of the sums of their bunches
+// res[i] is the result of bunch order[i]
+template<class R, class T> T comp_total(volce::solver &s, const vector<R> &res, const vector<unsigned int> &order, 
+		T R::*val, const T one){
+	vector<T> sum(s.ncomps());
+	for (unsigned int i = 0; i < res.size(); i++)
+		sum[s.get_comp(order[i])] = sum[s.get_comp(order[i])] + res[i].*val;
+	T total = one;
+	for (unsigned int c = 0; c < sum.size(); c++)
+		total = total * sum[c];
+	return total;
+}
+
+// global errors of the workers are reported by the main thread
+void global_exit(const volce::global_error &e){
+	cout << e.what() << flush;
+	exit(e.status);
+}
+
 int main(int argc, char **argv) {
 
 	auto t1 = Clock::now();
@@ -96,9 +150,15 @@ int main(int argc, char **argv) {
 	double 	maxc 		= 1;
 	double 	minc 		= 0.01;	// first round weight
 	bool	bunch		= true;
+	bool	prime		= false;
 	bool 	fact 		= true;
+	bool	comp		= true;
 	bool	ge			= true;
 	int 	verbosity 	= 1;
+	int		threads		= 1;
+	int		ethreads	= 1;
+	string	cachedir	= "";
+	unsigned long seed	= 0;
 
 	//auxiliary variables
 	//clock_t c_start, c_end;
@@ -182,6 +242,15 @@ int main(int argc, char **argv) {
 				cout << "Use '-h' or '--help' for help." << endl;
 				exit(0);
 			}
+		} else if (key == "-prime") {
+			// enable prime bunches
+			try {
+				prime = stoi(value);
+			}catch (const invalid_argument&){
+				cout << "error: Invalid value \"" << value << "\" for argument \"" << key << "\"." << endl;
+				cout << "Use '-h' or '--help' for help." << endl;
+				exit(0);
+			}
 		} else if (key == "-fact") {
 			// enable factorization
 			try {
@@ -191,6 +260,15 @@ int main(int argc, char **argv) {
 				cout << "Use '-h' or '--help' for help." << endl;
 				exit(0);
 			}
+		} else if (key == "-comp") {
+			// enable decomposition
+			try {
+				comp = stoi(value);
+			}catch (const invalid_argument&){
+				cout << "error: Invalid value \"" << value << "\" for argument \"" << key << "\"." << endl;
+				cout << "Use '-h' or '--help' for help." << endl;
+				exit(0);
+			}
 		} else if (key == "-ge") {
 			// disable gauss elimination
 			try {
@@ -200,6 +278,41 @@ int main(int argc, char **argv) {
 				cout << "Use '-h' or '--help' for help." << endl;
 				exit(0);
 			}
+		} else if (key == "-j" || key == "-J") {
+			//number of threads
+			try {
+				threads = stoi(value);
+			}catch (const invalid_argument&){
+				cout << "error: Invalid value \"" << value << "\" for argument \"" << key << "\"." << endl;
+				cout << "Use '-h' or '--help' for help." << endl;
+				exit(0);
+			}
+		} else if (key == "-ej") {
+			//number of enumerating threads
+			try {
+				ethreads = stoi(value);
+			}catch (const invalid_argument&){
+				cout << "error: Invalid value \"" << value << "\" for argument \"" << key << "\"." << endl;
+				cout << "Use '-h' or '--help' for help." << endl;
+				exit(0);
+			}
+		} else if (key == "-seed") {
+			//seed of random walks
+			try {
+				seed = stoul(value);
+			}catch (const invalid_argument&){
+				cout << "error: Invalid value \"" << value << "\" for argument \"" << key << "\"." << endl;
+				cout << "Use '-h' or '--help' for help." << endl;
+				exit(0);
+			}
+		} else if (key == "-cache") {
+			//dir of persistent cache
+			if (offset < 0 || value == "") {
+				cout << "error: Invalid value \"" << value << "\" for argument \"" << key << "\"." << endl;
+				cout << "Use '-h' or '--help' for help." << endl;
+				exit(0);
+			}
+			cachedir = value;
 		} else if (key == "-verb") {
 			//set verbosity
 			try{
@@ -269,6 +382,9 @@ int main(int argc, char **argv) {
 			exit(0);
 		}
 
+		if (seed > 0)
+			cout << "-seed=" << seed << "\tSet seed of random walks to " << seed << "." << endl;
+
     }
     
     if (vinci) {
@@ -306,6 +422,12 @@ int main(int argc, char **argv) {
 	}else{
 		cout << "-bunch=1\tBunch strategy turned on." << endl;
 	}
+	
+	if (!prime) {
+		cout << "-prime=0\tPrime bunches turned off." << endl;
+	}else{
+		cout << "-prime=1\tPrime bunches turned on." << endl;
+	}
    
 	if (!fact) {
 		cout << "-fact=0\t\tConstraints factorization turned off." << endl;
@@ -313,12 +435,38 @@ int main(int argc, char **argv) {
 		cout << "-fact=1\t\tConstraints factorization turned on." << endl;
 	}
 	
+	if (!comp) {
+		cout << "-comp=0\t\tFormula decomposition turned off." << endl;
+	}else{
+		cout << "-comp=1\t\tFormula decomposition turned on." << endl;
+	}
+	
 	if (!ge && !v2l) {
 		cout << "-ge=0\t\tGauss Elimination turned off." << endl;
 	}else{
 		cout << "-ge=1\t\tGauss Elimination turned on." << endl;
 	}
 	
+	if (threads > 0)
+		cout << "-j=" << threads << "\t\tSet number of threads to " << threads << "." << endl;
+	else {
+		cout << "error: The number of threads should be positive." << endl;
+		cout << "Use '-h' or '--help' for help." << endl;
+		exit(0);
+	}
+	
+	if (ethreads > 0)
+		cout << "-ej=" << ethreads << "\t\tSet number of enumerating threads to " << ethreads << "." << endl;
+	else {
+		cout << "error: The number of enumerating threads should be positive." << endl;
+		cout << "Use '-h' or '--help' for help." << endl;
+		exit(0);
+	}
+	
+	if (cachedir != "") {
+		cout << "-cache=" << cachedir << "\tKeep results in \"" << cachedir << "\"." << endl;
+	}
+	
 	if (!verbosity) {
 		cout << "-verb=0\t\tPretty print turned off." << endl;
 	} else {
@@ -369,10 +517,14 @@ int main(int argc, char **argv) {
 	//initialize solver
 	volce::solver s(execdir, bindir, input_file);
 	s.enable_bunch = bunch;
+	s.enable_prime = prime;
 	s.enable_fact = fact;
+	s.enable_comp = comp;
 	if (v2l) s.enable_ge = true;
 	else s.enable_ge = ge;
 	s.wordlength = wordlength;
+	s.seed = seed;
+	if (cachedir != "") s.cache_open(cachedir);
 
 	if (verbosity > 0) {
   		cout << endl << "====================================" << endl;
@@ -403,10 +555,44 @@ int main(int argc, char **argv) {
   		cout << "====================================" << endl << endl;
  	}
  	
-	unsigned int count = 0;
-	printf("#Bunches: %d\n", count);
-	while (s.solve())
-		printf("\033[1A\r#Bunches: %d\n", ++count);
+	//bunches are computed by workers while z3 is still enumerating, 
+	//each worker has its own scratch, results are stored by index and 
+	//printed & summed in the order of cubes, so the totals do not depend on threads
+	volce::pool workers(threads);
+	vector<volce::vol_scratch> scratch(workers.size());
+	volce::bqueue<unsigned int> bunches(4 * workers.size());
+	
+	//results of a bunch, polyvest is the first round
+	struct bunch_res {
+		volce::rational latte, barvinok;
+		volce::bigvol alc, vinci, polyvest;
+		volce::VOL_RES_CLS v2l;
+		bunch_res() : latte(0), barvinok(0), alc(0), vinci(0), polyvest(0) {};
+	};
+	vector<vector<pair<unsigned int, bunch_res>>> done(workers.size());
+	
+	//enumerating threads find bunches in any order, pushed by their indices
+	std::atomic<unsigned int> count(0);
+	printf("#Bunches: %d\n", 0);
+	try {
+		workers.run(bunches, [&]() {
+			s.solve(ethreads, [&](unsigned int i) {
+				printf("\033[1A\r#Bunches: %d\n", ++count);
+				return bunches.push(i);
+			});
+		}, [&](unsigned int w, unsigned int i) {
+			bunch_res res;
+			if (latte) res.latte = s.call_latte(i, scratch[w]);
+			if (barvinok) res.barvinok = s.call_barvinok(i, scratch[w]);
+			if (alc) res.alc = s.call_alc(i, scratch[w]);
+			if (vinci) res.vinci = s.call_vinci(i, scratch[w]);
+			if (polyvest) res.polyvest = s.call_polyvest(i, epsilon, delta, minc, scratch[w]);
+			if (v2l) res.v2l = s.call_v2l(i, scratch[w]);
+			done[w].push_back(make_pair(i, res));
+		});
+	}catch (const volce::global_error &e){
+		global_exit(e);
+	}
 	
 	//cout << "#Bunches: " << s.bunch_list.size() << endl;
 	
@@ -417,20 +603,32 @@ int main(int argc, char **argv) {
   		ofstream fout(output_file, std::ios::app);
 		fout //<< input_file 
 			<< " unsat" << endl;
-	  	fout.close();	
+  		fout.close();	
 
 		return 1;
 	}
 		
  	//////////////////////////////////////////////////////////////////////
 	
-	double total_latte = 0;
-	double total_barvinok = 0;
-	double total_alc = 0;
-	double total_vinci = 0;
-	double total_polyvest = 0;
+	volce::rational total_latte = 0;
+	volce::rational total_barvinok = 0;
+	volce::bigvol total_alc = 0;
+	volce::bigvol total_vinci = 0;
+	volce::bigvol total_polyvest = 0;
 	volce::VOL_RES_CLS total_v2l = volce::VOL_RES_CLS(0, 0, 0);
 	
+	//enumerating threads number bunches as they find them, 
+	//res[i] is the result of bunch order[i] in the order of cubes
+	unsigned int nbunches = s.bunch_list.size();
+	vector<unsigned int> order;
+	s.bunch_order(order);
+	vector<unsigned int> pos(nbunches);
+	for (unsigned int i = 0; i < nbunches; i++) pos[order[i]] = i;
+	vector<bunch_res> res(nbunches);
+	for (unsigned int w = 0; w < done.size(); w++)
+		for (unsigned int k = 0; k < done[w].size(); k++)
+			res[pos[done[w][k].first]] = done[w][k].second;
+	
 	// lattice counting routine
 	if (latte) {
 
@@ -441,17 +639,15 @@ int main(int argc, char **argv) {
    			cout << "Index\tCount" << endl;
   		}
 		
-		for (unsigned int i = 0; i < s.bunch_list.size(); i++) {
+		for (unsigned int i = 0; i < nbunches; i++) {
 		
-			double res = s.call_latte(i);
-			
 			if (verbosity > 0) {
-				cout << i + 1 << "\t" << res << endl;
+				cout << i + 1 << "\t" << res[i].latte << endl;
 			}
 			
-			total_latte += res;
-			
 		}
+		
+		total_latte = comp_total(s, res, order, &bunch_res::latte, volce::rational(1));
 	}	
 	
 	if (barvinok) {
@@ -463,17 +659,15 @@ int main(int argc, char **argv) {
    			cout << "Index\tCount" << endl;
   		}
 		
-		for (unsigned int i = 0; i < s.bunch_list.size(); i++) {
+		for (unsigned int i = 0; i < nbunches; i++) {
 		
-			double res = s.call_barvinok(i);
-			
 			if (verbosity > 0) {
-				cout << i + 1 << "\t" << res << endl;
+				cout << i + 1 << "\t" << res[i].barvinok << endl;
 			}
 			
-			total_barvinok += res;
-			
 		}
+		
+		total_barvinok = comp_total(s, res, order, &bunch_res::barvinok, volce::rational(1));
 	}
 	
 	if (alc) {
@@ -485,17 +679,15 @@ int main(int argc, char **argv) {
    			cout << "Index\tCount" << endl;
   		}
 		
-		for (unsigned int i = 0; i < s.bunch_list.size(); i++) {
+		for (unsigned int i = 0; i < nbunches; i++) {
 		
-			double res = s.call_alc(i);
-			
 			if (verbosity > 0) {
-				cout << i + 1 << "\t" << res << endl;
+				cout << i + 1 << "\t" << res[i].alc << endl;
 			}
 			
-			total_alc += res;
-			
 		}
+		
+		total_alc = comp_total(s, res, order, &bunch_res::alc, volce::bigvol(1));
 	}
 	
 	// volume computation routine
@@ -508,46 +700,45 @@ int main(int argc, char **argv) {
    			cout << "Index\tVolume" << endl;
   		}
 		
-		for (unsigned int i = 0; i < s.bunch_list.size(); i++) {
+		for (unsigned int i = 0; i < nbunches; i++) {
 		
-			double vol = s.call_vinci(i);
-			
 			if (verbosity > 0) {
-				cout << i + 1 << "\t" << vol << endl;
+				cout << i + 1 << "\t" << res[i].vinci << endl;
 			}
 			
-			total_vinci += vol;
-			
-		}	
+		}
+		
+		total_vinci = comp_total(s, res, order, &bunch_res::vinci, volce::bigvol(1));	
 
 	}
 	
 	// volume estimation routine
 	if (polyvest) {
 	
-	  	if (verbosity > 0){
+  		if (verbosity > 0){
   			cout << endl << "====================================" << endl;
   			cout << "============ PolyVest ==============" << endl;
   			cout << "====================================" << endl << endl;
   		}
   		
-  		double *vol = new double[s.bunch_list.size()];
-  		double maxvol = 0;
+  		//volumes are compared within each component
+  		vector<volce::bigvol> vol(nbunches);
+  		vector<volce::bigvol> maxvol(s.ncomps(), 0);
+  		for (unsigned int i = 0; i < nbunches; i++)
+  			vol[i] = res[i].polyvest;
 
   		//first round
    		if (verbosity > 0){
    			cout << "FIRST ROUND" << endl;
    			cout << "Index\tVolume\t\tLatUB\t\tLatLB" << endl;
    		}
-   		for (unsigned int i = 0; i < s.bunch_list.size(); i++){
-
-			vol[i] = s.call_polyvest(i, epsilon, delta, minc);
+   		for (unsigned int i = 0; i < nbunches; i++){
   			
   			if (verbosity > 0) {
   				cout << i + 1 << "\t" << vol[i] << endl;
   			}
   				
-  			if (maxvol < vol[i]) maxvol = vol[i];
+  			if (maxvol[s.get_comp(order[i])] < vol[i]) maxvol[s.get_comp(order[i])] = vol[i];
   		}
 
   		//second round
@@ -556,27 +747,37 @@ int main(int argc, char **argv) {
   			cout << "Index\tCoef\tVolume" << endl;
   		}
   		
- 	  	for (unsigned int i = 0; i < s.bunch_list.size(); i++){
- 	  		
- 	  		if (vol[i] != 0) {
- 	  		
-	 	  		double coef = cal_coef(vol[i], maxvol, minc, maxc);
-	 	  		
-	 	  		if (coef > minc){
+  		vector<double> coef(nbunches, 0);
+  		for (unsigned int i = 0; i < nbunches; i++)
+  			if (vol[i] != 0) coef[i] = cal_coef(vol[i], maxvol[s.get_comp(order[i])], minc, maxc);
+  		
+  		//threads left idle by few bunches run more chains of each walk
+  		unsigned int nsec = 0;
+  		for (unsigned int i = 0; i < nbunches; i++)
+  			if (coef[i] > minc) nsec++;
+  		for (unsigned int w = 0; w < workers.size(); w++)
+  			scratch[w].chains = (nsec > 0 && nsec < workers.size()) ? workers.size() / nsec : 1;
+  		
+  		try {
+  			workers.run(nbunches, [&](unsigned int w, unsigned int i) {
+  				if (coef[i] > minc)
+  					vol[i] = s.call_polyvest(order[i], epsilon, delta, coef[i], scratch[w]);
+  			});
+  		}catch (const volce::global_error &e){
+  			global_exit(e);
+  		}
+  		
+ 	  	for (unsigned int i = 0; i < nbunches; i++){
  	  		
-		  			vol[i] = s.call_polyvest(i, epsilon, delta, coef);
-	  			
-	  				if (verbosity > 0) { 
-	  					cout << i + 1 << "\t" << coef << "\t" << vol[i] << endl;
-	  				}
-	  			}
+	 	  	if (coef[i] > minc && verbosity > 0) { 
+	 	  		cout << i + 1 << "\t" << coef[i] << "\t" << vol[i] << endl;
 			}
 
-			total_polyvest += vol[i];
+			res[i].polyvest = vol[i];
 			
   		}
   		
-  		delete[] vol;
+  		total_polyvest = comp_total(s, res, order, &bunch_res::polyvest, volce::bigvol(1));
 
 	}
 	
@@ -590,17 +791,15 @@ int main(int argc, char **argv) {
    			cout << "Index\tVolume\tLatUB\tLatLB" << endl;
   		}
 		
-		for (unsigned int i = 0; i < s.bunch_list.size(); i++) {
+		for (unsigned int i = 0; i < nbunches; i++) {
 		
-			volce::VOL_RES_CLS vol = s.call_v2l(i);
-			
 			if (verbosity > 0) {
-				cout << i + 1 << "\t" << vol.value << '\t' << vol.upper << '\t' << vol.lower << endl;
+				cout << i + 1 << "\t" << res[i].v2l.value << '\t' << res[i].v2l.upper << '\t' << res[i].v2l.lower << endl;
 			}
 			
-			total_v2l = total_v2l + vol;
-			
-		}	
+		}
+		
+		total_v2l = comp_total(s, res, order, &bunch_res::v2l, volce::VOL_RES_CLS(1, 1, 1));	
 
 	}
 
@@ -608,12 +807,14 @@ int main(int argc, char **argv) {
   		cout << endl << "====================================" << endl;
   		cout << "=========== Statistics =============" << endl;
   		cout << "====================================" << endl << endl;
+  		cout << "The number of components: " << s.ncomps() << endl;
   		cout << "The number of bunches: " << s.bunch_list.size() << endl;
   		cout << "The number of bunches (factorized):" << s.stats_fact_bunches << endl;
   		cout << "The number of calls (vol): " << s.stats_vol_calls << endl;
   		cout << "The number of vol reuses: " << s.stats_vol_reuses << endl;
   		cout << "The average dims for each call: " << (double)s.stats_total_dims / s.stats_vol_calls << endl;
   		cout << "The maximum dims for all calls: " << s.stats_max_dims << endl;
+  		cout << "The number of eliminated variables (GE): " << s.stats_ge_vars << endl;
 	}
 	
   	cout << endl << "====================================" << endl << endl;
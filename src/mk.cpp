@@ -323,7 +323,7 @@ const volce::solver::dagc volce::solver::mk_add(const std::vector<dagc> &params)
 	if (params.size() < 2) return mk_err(ERR_PARAM_MIS);
 
 	std::vector<dagc> new_params;
-	double value = 0;
+	rational value = 0;
 	
 	for (unsigned int i = 0; i < params.size(); i++) {
 		
@@ -390,7 +390,7 @@ const volce::solver::dagc volce::solver::mk_mul(const std::vector<dagc> &params)
 	if (params.size() < 2) return mk_err(ERR_PARAM_MIS);
 
 	std::vector<dagc> new_params;
-	double value = 1;
+	rational value = 1;
 	
 	for (unsigned int i = 0; i < params.size(); i++) {
 
@@ -400,7 +400,7 @@ const volce::solver::dagc volce::solver::mk_mul(const std::vector<dagc> &params)
 		if (params[i].isconst()) {
 			//merge constants
 			value *= params[i].nval();
-			if (value == 0) return mk_const(0);
+			if (value == 0) return mk_const(rational(0));
 		} else
 			new_params.push_back(params[i]);
 
@@ -418,7 +418,7 @@ const volce::solver::dagc volce::solver::mk_mul(const std::vector<dagc> &params)
 }
 
 //(* param multiplier)
-const volce::solver::dagc volce::solver::mk_mul(const dagc p, const double m) {
+const volce::solver::dagc volce::solver::mk_mul(const dagc p, const rational m) {
 
 	if (solving_initialized) err_solving_initialized();
 
@@ -427,7 +427,7 @@ const volce::solver::dagc volce::solver::mk_mul(const dagc p, const double m) {
 		return p;
 	} else if (m == 0) {
 		// 0 * p = 0
-		return mk_const(0);
+		return mk_const(rational(0));
 	} else if (p.isadd()) {
 		// '+' expr, distributive law
 		for (unsigned int i = 0; i < nop_list[p.id].size(); i++) 
@@ -453,12 +453,13 @@ const volce::solver::dagc volce::solver::mk_div(const dagc l, const dagc r) {
 	if (l.isbool() || r.isbool()) return mk_err(ERR_PARAM_NNUM);
 
 	if (r.isconst()) {
+		if (r.nval() == 0) return mk_err(ERR_ZERO_DIVISOR);
 		if (l.isconst()) {
 			//all constants
 			return mk_const(l.nval() / r.nval());
 		} else {
 			//divisor is zero
-			std::vector<dagc> new_params{l, mk_const(1.0 / r.nval())};
+			std::vector<dagc> new_params{l, mk_const(1 / r.nval())};
 			return mk_mul(new_params);
 		}
 	} else {
@@ -525,7 +526,7 @@ const volce::solver::dagc volce::solver::mk_ineq(const bool iseq, const dagc l,
 
 const volce::solver::dagc volce::solver::mk_ineq_core(const bool iseq, const dagc lhs, const dagc rhs) {
 
-	double constant = 0;
+	rational constant = 0;
 	std::vector<term> terms;
 
 	if (lhs.iscnum()) 
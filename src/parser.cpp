@@ -591,7 +591,9 @@ volce::solver::dagc volce::solver::parse_expr() {
 
 		if (isdigit(s[0])) {
 			//constant number
-			return mk_const(s);
+			rational v;
+			if (!rational::parse(s, v)) err_unkwn_sym(s, ln);
+			return mk_const(v);
 		} else {
 			boost::unordered_map<std::string, dagc>::iterator kmap_iter = key_map.find(s);
 			if (kmap_iter != key_map.end()) {
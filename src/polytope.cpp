@@ -11,7 +11,10 @@
 
 #include "polytope.h"
 #include "glpk.h"
+#include "vinci_lib.h"
 #include <boost/math/distributions/normal.hpp>
+#include <atomic>
+#include <thread>
 
 #define PI 3.1415926536
 
@@ -63,46 +66,26 @@ double zvalue(double x) {
 
 }
 
+// time mixed with a counter, polytopes created in the same second differ
+uint64_t polyvest::DefaultSeed(){
+	static std::atomic<uint64_t> counter(0);
+	return ((uint64_t)time(0) << 20) ^ counter++;
+}
+
 /*********** Enlarge polytope ***********/
+// max { A.row(i) * x | -0.5 <= xj <= 0.5 } = 0.5 * sum_j |A(i, j)|
 bool polytope::Enlarge(){
 
-	// for each hyperplane
-	for (int row_index = 0; row_index < m; row_index++) {
-			
-		// object 	  {	max A.row(i) * x }
-		// constraint { -0.5 <= xi <= 0.5 }
-		glp_prob *lp;
-		lp = glp_create_prob();
-		glp_set_obj_dir(lp, GLP_MAX);
-		//glp_add_rows(lp, 0);
-		glp_add_cols(lp, n);
-
-		//disable msg output
-		glp_smcp parm;
-		glp_init_smcp(&parm);
-		parm.msg_lev = GLP_MSG_ERR;
-
-		for (int j = 1; j < n + 1; j++)
-			glp_set_col_bnds(lp, j, GLP_DB, -0.5, 0.5);
-
-		// find { max newb }
-		for (int j = 1; j < n + 1; j++)
-			glp_set_obj_coef(lp, j, A(row_index, j - 1));
-
-		int err_glpk = glp_simplex(lp, &parm);
-		if (err_glpk != 0) {
-			cout << "GLPK Simplex method returns error: " << err_glpk << endl;
-			return false;
-		}
-		
-		double max = glp_get_obj_val(lp);
-		hpoffset[row_index] = max;
-		b(row_index) += max * 2;
-		
-		//cout << "row" << row_index + 1 << " hpoffset = " << max << endl;
+	for (int i = 0; i < m; i++) hpoffset[i] = 0;
 	
-		glp_delete_prob(lp);
-		
+	// column by column, A is column-major
+	const double *a = A.memptr();
+	for (int j = 0; j < n; j++, a += m)
+		for (int i = 0; i < m; i++) hpoffset[i] += fabs(a[i]);
+	
+	for (int i = 0; i < m; i++) {
+		hpoffset[i] *= 0.5;
+		b(i) += hpoffset[i] * 2;
 	}
 
 	return true;
@@ -110,97 +93,89 @@ bool polytope::Enlarge(){
 }
 
 
-/*********** Get Bounds ***********/
-void polytope::GetBounds(){
+/*********** Bounding Box LP ***********/
+boxlp::boxlp(const mat &A) : n(A.n_cols), obj(0) {
 
+	int m = A.n_rows;
+	
 	//init GLPK
-	glp_prob *lp;
 	lp = glp_create_prob();
 	glp_set_obj_dir(lp, GLP_MAX);
 	glp_add_rows(lp, m);
 	glp_add_cols(lp, n);
 
 	//disable msg output
-	glp_smcp parm;
 	glp_init_smcp(&parm);
 	parm.msg_lev = GLP_MSG_ERR;
 
-	//load constraints
-	int *ind = new int[n + 1];
-	double *val = new double[n + 1];
-	for (int i = 1; i < m + 1; i++){
-		for (int j = 1; j < n + 1; j++){
-			ind[j] = j, val[j] = A(i - 1, j - 1);
-		}
-		glp_set_mat_row(lp, i, n, ind, val);
-		glp_set_row_bnds(lp, i, GLP_UP, 0, b(i - 1));
-	}
-	delete []ind;
-	delete []val;
-	for (int i = 1; i < n + 1; i++)
-		glp_set_col_bnds(lp, i, GLP_FR, 0, 0);
-
-	//get bounds
-	for (int i = 0; i < n; i++){
-	
+	//load constraints, nonzeros only
+	vector<int> ind(n + 1);
+	vector<double> val(n + 1);
+	for (int i = 0; i < m; i++){
+		int len = 0;
 		for (int j = 0; j < n; j++)
-			glp_set_obj_coef(lp, j + 1, 0);
-
-		glp_set_obj_coef(lp, i + 1, 1);
-		glp_simplex(lp, &parm);
-		xmax[i] = glp_get_obj_val(lp);
+			if (A(i, j) != 0){
+				len++;
+				ind[len] = j + 1, val[len] = A(i, j);
+			}
+		glp_set_mat_row(lp, i + 1, len, ind.data(), val.data());
+		glp_set_row_bnds(lp, i + 1, GLP_FR, 0, 0);
+	}
+	for (int j = 1; j < n + 1; j++)
+		glp_set_col_bnds(lp, j, GLP_FR, 0, 0);
+}
 
-		glp_set_obj_coef(lp, i + 1, -1);
-		glp_simplex(lp, &parm);
-		xmin[i] = -glp_get_obj_val(lp);
+bool boxlp::Solve(int index, int dir, double &val, double *point){
 
+	//only the objective changes, the basis of the last solve is kept
+	if (obj != index + 1){
+		if (obj > 0) glp_set_obj_coef(lp, obj, 0);
+		obj = index + 1;
 	}
+	glp_set_obj_coef(lp, obj, dir > 0 ? 1 : -1);
+	glp_simplex(lp, &parm);
 	
-	glp_delete_prob(lp);
+	if (glp_get_status(lp) == GLP_UNBND) return false;
+	
+	val = dir > 0 ? glp_get_obj_val(lp) : -glp_get_obj_val(lp);
+	if (point != NULL)
+		for (int j = 0; j < n; j++) point[j] = glp_get_col_prim(lp, j + 1);
+	return true;
 }
 
-void polytope::GetBounds(int index){
 
-	//init GLPK
-	glp_prob *lp;
-	lp = glp_create_prob();
-	glp_set_obj_dir(lp, GLP_MAX);
-	glp_add_rows(lp, m);
-	glp_add_cols(lp, n);
+/*********** Get Bounds ***********/
+void polytope::GetBounds(){
 
-	//disable msg output
-	glp_smcp parm;
-	glp_init_smcp(&parm);
-	parm.msg_lev = GLP_MSG_ERR;
+	boxlp lp(A);
+	for (int i = 0; i < m; i++)
+		lp.SetRowBnds(i, GLP_UP, 0, b(i));
 
-	//load constraints
-	int *ind = new int[n + 1];
-	double *val = new double[n + 1];
-	for (int i = 1; i < m + 1; i++){
-		for (int j = 1; j < n + 1; j++){
-			ind[j] = j, val[j] = A(i - 1, j - 1);
-		}
-		glp_set_mat_row(lp, i, n, ind, val);
-		glp_set_row_bnds(lp, i, GLP_UP, 0, b(i - 1));
+	//get bounds
+	for (int i = 0; i < n; i++){
+		lp.Solve(i, 1, xmax[i]);
+		lp.Solve(i, -1, xmin[i]);
 	}
-	delete []ind;
-	delete []val;
-	for (int i = 1; i < n + 1; i++)
-		glp_set_col_bnds(lp, i, GLP_FR, 0, 0);
+}
 
-	//get bounds of x[index]
-	for (int j = 0; j < n; j++)
-		glp_set_obj_coef(lp, j + 1, 0);
+void polytope::GetBounds(int index){
 
-	glp_set_obj_coef(lp, index + 1, -1);
-	glp_simplex(lp, &parm);
-	xmin[index] = -glp_get_obj_val(lp);
+	boxlp lp(A);
+	for (int i = 0; i < m; i++)
+		lp.SetRowBnds(i, GLP_UP, 0, b(i));
 
-	glp_set_obj_coef(lp, index + 1, 1);
-	glp_simplex(lp, &parm);
-	xmax[index] = glp_get_obj_val(lp);
-	
-	glp_delete_prob(lp);
+	//get bounds of x[index]
+	lp.Solve(index, -1, xmin[index]);
+	lp.Solve(index, 1, xmax[index]);
+}
+
+void polytope::SetBox(const double *max, const double *min, const vec &center){
+	for (int i = 0; i < n; i++){
+		xmax[i] = max[i];
+		xmin[i] = min[i];
+	}
+	box_center = center;
+	box_set = true;
 }
 
 
@@ -208,58 +183,25 @@ void polytope::GetBounds(int index){
 void polytope::genInitE(double &R2, vec &Ori){
 	R2 = 0, Ori.zeros();
 
-	//init GLPK
-	glp_prob *lp;
-	lp = glp_create_prob();
-	glp_set_obj_dir(lp, GLP_MAX);
-	glp_add_rows(lp, m);
-	glp_add_cols(lp, n);
-
-	//disable msg output
-	glp_smcp parm;
-	glp_init_smcp(&parm);
-	parm.msg_lev = GLP_MSG_ERR;
-
-	//load constraints
-	int *ind = new int[n + 1];
-	double *val = new double[n + 1];
-	for (int i = 1; i < m + 1; i++){
-		for (int j = 1; j < n + 1; j++){
-			ind[j] = j, val[j] = A(i - 1, j - 1);
+	//get bounds, unless they are given by SetBox
+	if (!box_set){
+		boxlp lp(A);
+		for (int i = 0; i < m; i++)
+			lp.SetRowBnds(i, GLP_UP, 0, b(i));
+
+		vec point(n);
+		for (int i = 0; i < n; i++){
+			lp.Solve(i, 1, xmax[i], point.memptr());
+			Ori += point;
+			lp.Solve(i, -1, xmin[i], point.memptr());
+			Ori += point;
 		}
-		glp_set_mat_row(lp, i, n, ind, val);
-		glp_set_row_bnds(lp, i, GLP_UP, 0, b(i - 1));
-	}
-	delete []ind;
-	delete []val;
-	for (int i = 1; i < n + 1; i++)
-		glp_set_col_bnds(lp, i, GLP_FR, 0, 0);
-
-	//get bounds
-	for (int i = 0; i < n; i++){
-		double max, min;
-		for (int j = 0; j < n; j++)
-			glp_set_obj_coef(lp, j + 1, 0);
-
-		glp_set_obj_coef(lp, i + 1, 1);
-		glp_simplex(lp, &parm);
-		max = glp_get_obj_val(lp);
-		for (int j = 0; j < n; j++)
-			Ori(j) += glp_get_col_prim(lp, j + 1);
-
-		glp_set_obj_coef(lp, i + 1, -1);
-		glp_simplex(lp, &parm);
-		min = -glp_get_obj_val(lp);
-		for (int j = 0; j < n; j++)
-			Ori(j) += glp_get_col_prim(lp, j + 1);
-
-		R2 += (max - min) * (max - min);
-		xmax[i] = max;
-		xmin[i] = min;
-	}
-	Ori = Ori / (2 * n);
+		Ori = Ori / (2 * n);
+	} else
+		Ori = box_center;
 	
-	glp_delete_prob(lp);
+	for (int i = 0; i < n; i++)
+		R2 += (xmax[i] - xmin[i]) * (xmax[i] - xmin[i]);
 }
 
 /*********** Find Affine Transformation via Ellipsoid Method ***********/
@@ -342,13 +284,6 @@ bool polytope::AffineTrans(){
 
 	if (!msg_off) cout << "The number of iterations: " << counter << endl;
 
-	rowvec exp(n);
-	exp.ones();
-	for (int i = 0; i < n; i++){
-		B[i] = b / A.col(i);
-		Ai[i] = A / (A.col(i) * exp);
-	}
-	
 	determinant = det(Trans) / pow(beta_r, n);
 	
 	// How to obtain inverse?
@@ -361,38 +296,65 @@ bool polytope::AffineTrans(){
 
 }
 
-double polytope::EstimateVol(double epsilon, double delta, double coef = 1.0){
-	int k, i, j;
+// nchains independent chains share the samples of each phase, 
+// their counts are merged so the sample size and the (epsilon, delta) bound are kept
+double polytope::EstimateVol(double epsilon, double delta, double coef, int nchains){
+	int k, i, c;
 
 	boost::math::normal dist(0.0, 1.0);
 	const double z = boost::math::quantile(dist, 1.0-delta/2);
 	const long stepsz = coef * pow((z * l / log(1+epsilon) + z), 2) + 1; //size of sampling
-	long counter = 0;
 
 	double *alpha = new double[l];
 	long *volK = new long[l];
 	memset(alpha, 0, l * sizeof(double));
 	memset(volK, 0, l * sizeof(long));
 	
-	x.zeros();
+	//chains are seeded by the generator of the polytope
+	if (nchains < 1) nchains = 1;
+	vector<vec> cx(nchains, zeros<vec>(n));
+	vector<vec> cslack(nchains, b);
+	vector<rng> cgen(nchains);
+	for (c = 0; c < nchains; c++) cgen[c].Seed(gen.Next());
+	vector<vector<long> > cvolK(nchains, vector<long>(l));
+	
 	for (k = l - 2; k >= 0; k--){
-		for (i = volK[k + 1]; i < stepsz; i++){
-			counter++;
-			double m = 1;
-			for (j = 0; j < n; j++) m = walk(k);
-			
-			if (m < r2[0]) volK[0]++;
-			else if (m < r2[k])
-				volK[(int)trunc(n * log(m) / (log((double)2) * 2)) + 1]++;
-		}
+		long nsamples = stepsz - volK[k + 1];
+		
+		auto chain = [&, k](int c){
+			long *cnt = cvolK[c].data();
+			memset(cnt, 0, l * sizeof(long));
+			for (long s = nsamples * c / nchains; s < nsamples * (c + 1) / nchains; s++){
+				double m = 1;
+				for (int j = 0; j < n; j++) m = walk(k, cx[c], cslack[c], cgen[c]);
+				
+				if (m < r2[0]) cnt[0]++;
+				else if (m < r2[k])
+					cnt[(int)trunc(n * log(m) / (log((double)2) * 2)) + 1]++;
+			}
+		};
+		
+		vector<thread> threads;
+		for (c = 1; c < nchains; c++) threads.push_back(thread(chain, c));
+		chain(0);
+		for (c = 1; c < nchains; c++) threads[c - 1].join();
+		
+		for (c = 0; c < nchains; c++)
+			for (i = 0; i < l; i++) volK[i] += cvolK[c][i];
+		
 		for (i = 0; i < k; i++){
 			volK[k] += volK[i];
 		}
 		if (volK[k] < stepsz){
 			alpha[k] = (double)(stepsz) / volK[k];
-			x = x / pow((double)2, (double)1 / n);
+			for (c = 0; c < nchains; c++){
+				cx[c] = cx[c] / pow((double)2, (double)1 / n);
+				cslack[c] = b - A * cx[c];
+			}
 		}else alpha[k] = 1;
 	}
+	x = cx[0];
+	slack = cslack[0];
 	
 	vol = uballVol(n) * determinant;
 	if (!msg_off) cout << "k\tr^2\t\tvol(k+1)/vol(k)" << endl;
@@ -411,95 +373,55 @@ double polytope::EstimateVol(double epsilon, double delta, double coef = 1.0){
 double polytope::ExactVol()
 {
 
-	// compute
-	string fileName = "vinci_in_tmp"; //.ine
-
-	ofstream ofile;
-	
-	ofile.open(fileName + ".ine");
-	if (!ofile.is_open())
-	{
-		cout << "Error: " << fileName << " cannot open!" << endl;
-		exit(-1);
-	}
-
-	//set printf format
-	ofile.setf(std::ios::fixed, std::ios::floatfield);
-
-	ofile << "H-representation" << endl;
-	ofile << "begin" << std::endl;
-	ofile << m << " " << n + 1 << " real" << endl;
+	// Ax <= b, row by row
+	vector<double> planes(m * (n + 1));
 	
-	for(int i = 0; i < m; i++)
+	for (int i = 0; i < m; i++)
 	{
-		ofile << b[i] << " ";
 		for (int j = 0; j < n; j++)
-				ofile << -A(i, j) << " ";
-		ofile << endl;
+			planes[i * (n + 1) + j] = A(i, j);
+		planes[i * (n + 1) + n] = b(i);
 	}
 	
-	ofile << "end" << endl;
-	
-	ofile.close();
-	
-	//execute vinci
-	string cmd = "./bin/vinci " + fileName + " >/dev/null";
-	int proc = system(cmd.c_str());
-	
-	//read result
-	ifstream ifile;
-	vol = 0;
-	fileName = "vinci.result";
-
-	ifile.open(fileName);
-	if (!ifile.is_open())
-	{
-		cout << "Error: " << fileName << " cannot open!" << endl;
-		exit(-1);
-	}
-	ifile >> vol;
-	ifile.close();	
+	vol = vinci_volume(m, n, planes.data());
 	
 	return vol;
 }
 
-// private walk for estimation
-double polytope::walk(int k)
+// private walk for estimation, on the point x of a chain
+double polytope::walk(int k, vec &x, vec &slack, rng &gen)
 {
 	double r, max, min, C = 0;
-	int dir = randi(n);
-	vec::col_iterator it, itA, end;
+	int dir = gen.Next() % n;
+	const double *px = x.memptr();
 
-	for (it = x.begin(), end = x.end(); it != end; ++it) C += *it * *it;
+	for (int j = 0; j < n; j++) C += px[j] * px[j];
 	C -= x(dir) * x(dir);
 	r = sqrt(r2[k + 1] - C);
 	max = r - x(dir), min = -r - x(dir);
 
 //A(x + t v) <= b
 //Av t <= b - Ax
-	vec bound = B[dir] - Ai[dir] * x;
-	for (it = bound.begin(), end = bound.end(), itA = A.begin_col(dir); it != end; ++it, ++itA){
-		if (*itA > 0){
-			if (*it < max) max = *it;
-		}else if (*itA < 0)
-			if (*it > min) min = *it; 
+	const double *a = A.colptr(dir);
+	double *s = slack.memptr();
+	for (int i = 0; i < m; i++){
+		if (a[i] > 0){
+			if (s[i] / a[i] < max) max = s[i] / a[i];
+		}else if (a[i] < 0)
+			if (s[i] / a[i] > min) min = s[i] / a[i];
 	}
 
-	double t = x(dir) + randd(max - min) + min;
-	x(dir) = t;
+	double t = gen.Uniform() * (max - min) + min;
+	x(dir) += t;
+	for (int i = 0; i < m; i++) s[i] -= t * a[i];
 
-	return (C + t * t);
+	return (C + x(dir) * x(dir));
 }
 
 // public Walk method
 void polytope::PrepForWalk() {
 
-	rowvec exp(n);
-	exp.ones();
-	for (int i = 0; i < n; i++){
-		B[i] = b / A.col(i);
-		Ai[i] = A / (A.col(i) * exp);
-	}
+	slack = b - A * x;
 
 }
 
@@ -507,23 +429,24 @@ void polytope::Walk() {
 
 	double max, min = 0;
 	int dir = randi(n);
-	vec::col_iterator it, itA, end;
 
 	max = std::numeric_limits<double>::max();
 	min = -std::numeric_limits<double>::max();
 
 //A(x + t v) <= b
 //Av t <= b - Ax
-	vec bound = B[dir] - Ai[dir] * x;
-	for (it = bound.begin(), end = bound.end(), itA = A.begin_col(dir); it != end; ++it, ++itA){
-		if (*itA > 0){
-			if (*it < max) max = *it;
-		}else if (*itA < 0)
-			if (*it > min) min = *it; 
+	const double *a = A.colptr(dir);
+	double *s = slack.memptr();
+	for (int i = 0; i < m; i++){
+		if (a[i] > 0){
+			if (s[i] / a[i] < max) max = s[i] / a[i];
+		}else if (a[i] < 0)
+			if (s[i] / a[i] > min) min = s[i] / a[i];
 	}
 
-	double t = x(dir) + randd(max - min) + min;
-	x(dir) = t;
+	double t = randd(max - min) + min;
+	x(dir) += t;
+	for (int i = 0; i < m; i++) s[i] -= t * a[i];
 
 	return ;
 
@@ -567,6 +490,7 @@ bool polytope::CUonBoundary(vec point)
 	{	
 		// Enlarged bigP
 		// b(i) - 2 * hpoffset[i] = original b(i)
+		// A.row(i) * y ranges over offset(i) +- hpoffset[i] in the cube
 		if (offset(i) - hpoffset[i] > b(i) - 2 * hpoffset[i]) 
 			return false;
 		else if (offset(i) + hpoffset[i] >= b(i) - 2 * hpoffset[i])
@@ -15,12 +15,70 @@
 #include "math.h"
 #include "time.h"
 #include "memory.h"
+#include "glpk.h"
+#include <stdint.h>
 
 #ifndef POLYVOL_H
 #define POLYVOL_H
 
 namespace polyvest{
 
+// xoshiro256** generator, every polytope owns one
+class rng{
+public:
+	rng(uint64_t seed = 0){ Seed(seed); }
+	
+	// splitmix64 expands the seed into the state
+	void 	Seed(uint64_t seed){
+		for (int i = 0; i < 4; i++){
+			uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+			s[i] = z ^ (z >> 31);
+		}
+	}
+	
+	uint64_t Next(){
+		uint64_t r = rotl(s[1] * 5, 7) * 9;
+		uint64_t t = s[1] << 17;
+		s[2] ^= s[0]; s[3] ^= s[1]; s[1] ^= s[2]; s[0] ^= s[3];
+		s[2] ^= t;
+		s[3] = rotl(s[3], 45);
+		return r;
+	}
+	
+	// uniform in [0, 1)
+	double 	Uniform(){ return (Next() >> 11) * (1.0 / 9007199254740992.0); }
+	
+private:
+	uint64_t s[4];
+	static uint64_t rotl(uint64_t x, int k){ return (x << k) | (x >> (64 - k)); }
+};
+
+// distinct seeds for polytopes that are not seeded explicitly
+uint64_t DefaultSeed();
+
+// bounding box of {x | A x in row bounds} by LPs on one GLPK problem,
+// the matrix is loaded once, each solve starts from the basis of the previous one
+class boxlp{
+public:
+	boxlp(const arma::mat &A);
+	~boxlp(){ glp_delete_prob(lp); }
+	
+	// bounds of row i, type is GLP_LO, GLP_UP, GLP_DB or GLP_FX
+	void	SetRowBnds(int i, int type, double lo, double up){ glp_set_row_bnds(lp, i + 1, type, lo, up); }
+	
+	// max of x[index] if dir > 0, otherwise min, false if unbounded
+	// point receives the optimal x unless it is NULL
+	bool	Solve(int index, int dir, double &val, double *point = NULL);
+
+private:
+	int 	n;
+	int 	obj;		// column in the objective, 0 = none
+	glp_prob *lp;
+	glp_smcp parm;
+};
+
 class polytope{
 public:
 	polytope(int rows, int cols);
@@ -34,10 +92,16 @@ public:
 	void	GetBounds(int index);
 	bool	Enlarge();
 	bool 	AffineTrans();
-	double 	EstimateVol(double epsilon, double delta, double coef);
-	double	ExactVol();		// call vinci
+	double 	EstimateVol(double epsilon, double delta, double coef, int nchains = 1);
+	double	ExactVol();		// call vinci library, negative if vinci fails
 
-	void	PrepForWalk();
+	void	Seed(uint64_t seed){ gen.Seed(seed); }
+	
+	// box and center of its extreme points already solved elsewhere, 
+	// AffineTrans then skips its LPs
+	void	SetBox(const double *max, const double *min, const arma::vec &center);
+
+	void	PrepForWalk();	// call it again once x is changed outside Walk
 	void	Walk();
 	arma::vec GetInvPoint(arma::vec point);
 	bool	isInside(arma::vec point);
@@ -60,6 +124,7 @@ public:
 
 	// random walk point
 	arma::vec x;
+	arma::vec slack;	// b - A * x, kept up to date by the walks
 	
 	// upper & lower bounds for each xi
 	double 	*xmax;
@@ -67,11 +132,15 @@ public:
 	double 	*hpoffset;
 	
 private:
-	double 	walk(int k);
+	bool	box_set;
+	arma::vec box_center;
+
+	double 	walk(int k, arma::vec &x, arma::vec &slack, rng &gen);
 	void 	genInitE(double &R2, arma::vec &Ori);
 
-	double 	randd(double u){ return rand() * u / RAND_MAX; }
-	int 	randi(int u){ return rand() % u; }
+	rng		gen;
+	double 	randd(double u){ return gen.Uniform() * u; }
+	int 	randi(int u){ return gen.Next() % u; }
 
 	arma::mat invT;		// to compute invert points
 	arma::vec invOri;
@@ -80,9 +149,6 @@ private:
 	double	determinant;
 	int 	l;
 	double 	*r2;
-
-	arma::vec *B;
-	arma::mat *Ai;
 };
 
 inline polytope::polytope(int rows, int cols) :
@@ -92,13 +158,14 @@ inline polytope::polytope(int rows, int cols) :
 	A(rows, cols),
 	b(rows),
 	x(cols),
+	slack(rows),
+	box_set(false),
+	gen(DefaultSeed()),
 	invT(cols, cols),
 	invOri(cols), 
 	vol(0),
 	determinant(0)
 {
-	srand((int)time(0));
-
 	beta_r = 2 * n; //2 * n;
 
 	l = (int)(n * log((double)beta_r) / log((double)2)) + 2;
@@ -111,9 +178,6 @@ inline polytope::polytope(int rows, int cols) :
 	xmax = new double[n] ();
 	xmin = new double[n] ();
 	hpoffset = new double[m] ();
-
-	B = new arma::vec[n];
-	Ai = new arma::mat[n];
 }
 
 inline polytope::~polytope(){
@@ -122,8 +186,6 @@ inline polytope::~polytope(){
 	delete []xmax;
 	delete []xmin;
 	delete []hpoffset;
-	delete []B;
-	delete []Ai;
 }
 
 }
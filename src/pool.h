@@ -0,0 +1,152 @@
+/*  pool.h
+ *
+ *  Copyright (C) 2016-2024 Cunjing Ge.
+ *
+ *  All rights reserved.
+ *
+ *  This file is part of sharpSMT.
+ *  See COPYING for more information on using this software.
+ */
+
+#include <global.h>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+
+#ifndef POOL_HEADER
+#define POOL_HEADER
+
+namespace volce {
+
+// a bounded blocking queue between a producer and workers
+// push waits while the queue is full, pop waits while it is empty,
+// pop returns false once the queue is closed and drained, 
+// push returns false once it is closed, the item is dropped then
+template <typename T>
+class bqueue {
+public:
+	bqueue(const unsigned int capacity) : cap(capacity > 0 ? capacity : 1), closed(false) {};
+	~bqueue() {};
+	
+	const bool push(const T &item) {
+		std::unique_lock<std::mutex> lock(mtx);
+		not_full.wait(lock, [this]() { return items.size() < cap || closed; });
+		if (closed) return false;
+		items.push_back(item);
+		not_empty.notify_one();
+		return true;
+	};
+	
+	const bool pop(T &item) {
+		std::unique_lock<std::mutex> lock(mtx);
+		not_empty.wait(lock, [this]() { return !items.empty() || closed; });
+		if (items.empty()) return false;
+		item = items.front();
+		items.pop_front();
+		not_full.notify_one();
+		return true;
+	};
+	
+	// no more items
+	void close() {
+		std::lock_guard<std::mutex> lock(mtx);
+		closed = true;
+		not_empty.notify_all();
+		not_full.notify_all();
+	};
+	
+private:
+	unsigned int			cap;
+	bool					closed;
+	std::deque<T>			items;
+	std::mutex				mtx;
+	std::condition_variable	not_full;
+	std::condition_variable	not_empty;
+};
+
+// a pool of workers for independent tasks
+// tasks 0, 1, ..., n - 1 are handed out in order to the next idle worker,
+// the task function receives the id of the worker and the index of the task, 
+// the first exception thrown by a task stops the pool and is rethrown by run 
+// in the calling thread, once all workers are joined
+class pool {
+public:
+	pool(const unsigned int nworkers) : nw(nworkers > 0 ? nworkers : 1) {};
+	~pool() {};
+	
+	const unsigned int size() const { return nw; };
+	
+	void run(const unsigned int ntasks, const std::function<void(unsigned int, unsigned int)> &task) {
+		
+		// no threads for a single worker
+		if (nw == 1) {
+			for (unsigned int i = 0; i < ntasks; i++) task(0, i);
+			return;
+		}
+		
+		std::atomic<unsigned int> next(0);
+		std::vector<std::thread> workers;
+		for (unsigned int w = 0; w < nw; w++)
+			workers.push_back(std::thread([this, &next, &task, ntasks, w]() {
+				for (unsigned int i = next++; i < ntasks && !failed; i = next++) 
+					guard([&]() { task(w, i); });
+			}));
+		for (unsigned int w = 0; w < nw; w++) workers[w].join();
+		rethrow();
+	};
+	
+	// workers take tasks from the queue until it is closed, 
+	// the producer runs in the calling thread meanwhile, 
+	// it should stop once a push fails, the queue is closed by a failed worker
+	void run(bqueue<unsigned int> &queue, const std::function<void()> &producer,
+			const std::function<void(unsigned int, unsigned int)> &task) {
+		
+		//a failed worker closes the queue, so that the producer is not blocked
+		std::vector<std::thread> workers;
+		for (unsigned int w = 0; w < nw; w++)
+			workers.push_back(std::thread([this, &queue, &task, w]() {
+				unsigned int i;
+				while (!failed && queue.pop(i)) 
+					if (!guard([&]() { task(w, i); })) queue.close();
+			}));
+		guard(producer);
+		queue.close();
+		for (unsigned int w = 0; w < nw; w++) workers[w].join();
+		rethrow();
+	};
+	
+private:
+	unsigned int		nw;
+	std::atomic<bool>	failed{false};
+	std::exception_ptr	error;
+	std::mutex			error_mutex;
+	
+	// run a task, keep the first exception of all workers
+	const bool guard(const std::function<void()> &f) {
+		try {
+			f();
+			return true;
+		} catch (...) {
+			std::lock_guard<std::mutex> lock(error_mutex);
+			if (!error) error = std::current_exception();
+			failed = true;
+			return false;
+		}
+	};
+	
+	void rethrow() {
+		if (!failed) return;
+		std::exception_ptr e = error;
+		error = nullptr;
+		failed = false;
+		std::rethrow_exception(e);
+	};
+};
+
+}
+
+#endif
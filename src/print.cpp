@@ -84,18 +84,19 @@ void volce::solver::print_model() {
 
 	std::cout << "(and" << std::endl;
 
-	for (unsigned int i = 0; i < vbool_list.size(); i++) {
-		if (vbool_list(i).is_true())
+	//the model of the solver's own enumerator, nothing before the first bunch
+	for (unsigned int i = 0; i < enumr.vbool_val.size(); i++) {
+		if (enumr.vbool_val[i].is_true())
 			std::cout << "  (= " << vbool_list.name(i) << " true)" << std::endl;
-		else if (vbool_list(i).is_false())
+		else if (enumr.vbool_val[i].is_false())
 			std::cout << "  (= " << vbool_list.name(i) << " false)" << std::endl;
 	}
-	for (unsigned int i = 0; i < ineq_list.size(); i++) {
+	for (unsigned int i = 0; i < enumr.ineq_val.size(); i++) {
 		// print ineq with assignment (true or false)
-		if (ineq_list(i).is_true()) {
+		if (enumr.ineq_val[i].is_true()) {
 			// is true
 			std::cout << "  (= " << ineq_list.name(i) << " true)" << std::endl;
-		} else if (ineq_list(i).is_false()) {
+		} else if (enumr.ineq_val[i].is_false()) {
 			// is false
 			std::cout << "  (= " << ineq_list.name(i) << " false)" << std::endl;
 		}
@@ -0,0 +1,207 @@
+/*  rational.cpp
+ *
+ *  Copyright (C) 2016-2024 Cunjing Ge.
+ *
+ *  All rights reserved.
+ *
+ *  This file is part of sharpSMT.
+ *  See COPYING for more information on using this software.
+ */
+
+#include "rational.h"
+#include <limits>
+#include <functional>
+#include <cmath>
+#include <stdexcept>
+
+//gcd of absolute values
+static unsigned __int128 gcd128(unsigned __int128 a, unsigned __int128 b) {
+	while (b != 0) {
+		unsigned __int128 t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+static unsigned __int128 abs128(const __int128 v) {
+	return (v < 0) ? -(unsigned __int128)v : (unsigned __int128)v;
+}
+
+volce::rational::rational(const std::string &s) : n(0), d(1), big(NULL) {
+	if (!parse(s, *this)) throw std::invalid_argument("invalid number \"" + s + "\"");
+}
+
+const bool volce::rational::parse(const std::string &s, rational &r) {
+
+	//sign, integer digits, fraction digits and denominator, the whole string is taken
+	unsigned int i = 0;
+	bool neg = false;
+	if (i < s.size() && (s[i] == '-' || s[i] == '+')) neg = (s[i++] == '-');
+	std::string digits;
+	for (; i < s.size() && isdigit(s[i]); i++) digits += s[i];
+	if (digits.empty()) return false;
+	
+	std::string dens = "1";
+	if (i < s.size() && s[i] == '.') {
+		unsigned int nfrac = 0;
+		for (i++; i < s.size() && isdigit(s[i]); i++, nfrac++) digits += s[i];
+		if (nfrac == 0) return false;
+		dens += std::string(nfrac, '0');
+	} else if (i < s.size() && s[i] == '/') {
+		dens.clear();
+		for (i++; i < s.size() && isdigit(s[i]); i++) dens += s[i];
+		if (dens.empty()) return false;
+	}
+	if (i < s.size()) return false;
+
+	mpz_class den(dens);
+	if (den == 0) return false;
+	mpq_class q = mpq_class(mpz_class(digits), den);
+	q.canonicalize();
+	if (neg) q = -q;
+	r.set(q);
+	return true;
+}
+
+volce::rational::rational(const double v) : n(0), d(1), big(NULL) {
+	assert(std::isfinite(v));
+	set(mpq_class(v));
+}
+
+const volce::rational volce::rational::pow2(const unsigned long k) {
+	rational r;
+	if (k < 62) r.n = 1L << k;
+	else {
+		mpz_class z;
+		mpz_ui_pow_ui(z.get_mpz_t(), 2, k);
+		r.set(mpq_class(z));
+	}
+	return r;
+}
+
+const mpq_class volce::rational::get_q() const {
+	if (big) return *big;
+	return mpq_class(mpz_class(n), mpz_class(d));
+}
+
+void volce::rational::set(__int128 num, __int128 den) {
+
+	if (den < 0) { num = -num; den = -den; }
+	unsigned __int128 g = gcd128(abs128(num), (unsigned __int128)den);
+	if (g > 1) { num /= (__int128)g; den /= (__int128)g; }
+
+	delete big;
+	big = NULL;
+	//n = LONG_MIN is avoided so that negation never overflows
+	if (num > -(__int128)std::numeric_limits<long>::max() && num <= std::numeric_limits<long>::max() &&
+		den <= std::numeric_limits<long>::max()) {
+		n = (long)num;
+		d = (long)den;
+	} else {
+		//exceeds machine integers
+		mpz_class p, q;
+		unsigned __int128 a = abs128(num);
+		mpz_import(p.get_mpz_t(), 1, -1, sizeof(a), 0, 0, &a);
+		if (num < 0) p = -p;
+		unsigned __int128 b = (unsigned __int128)den;
+		mpz_import(q.get_mpz_t(), 1, -1, sizeof(b), 0, 0, &b);
+		big = new mpq_class(p, q);
+	}
+}
+
+void volce::rational::set(const mpq_class &q) {
+
+	delete big;
+	big = NULL;
+	if (q.get_num().fits_slong_p() && q.get_num() != std::numeric_limits<long>::min() &&
+		q.get_den().fits_slong_p()) {
+		n = q.get_num().get_si();
+		d = q.get_den().get_si();
+	} else big = new mpq_class(q);
+}
+
+const volce::rational volce::operator+(const rational &a, const rational &b) {
+	rational r;
+	if (a.big || b.big) r.set(mpq_class(a.get_q() + b.get_q()));
+	else r.set((__int128)a.n * b.d + (__int128)b.n * a.d, (__int128)a.d * b.d);
+	return r;
+}
+
+const volce::rational volce::operator-(const rational &a, const rational &b) {
+	rational r;
+	if (a.big || b.big) r.set(mpq_class(a.get_q() - b.get_q()));
+	else r.set((__int128)a.n * b.d - (__int128)b.n * a.d, (__int128)a.d * b.d);
+	return r;
+}
+
+const volce::rational volce::operator*(const rational &a, const rational &b) {
+	rational r;
+	if (a.big || b.big) r.set(mpq_class(a.get_q() * b.get_q()));
+	else r.set((__int128)a.n * b.n, (__int128)a.d * b.d);
+	return r;
+}
+
+const volce::rational volce::operator/(const rational &a, const rational &b) {
+	assert(b != 0);
+	rational r;
+	if (a.big || b.big) r.set(mpq_class(a.get_q() / b.get_q()));
+	else r.set((__int128)a.n * b.d, (__int128)a.d * b.n);
+	return r;
+}
+
+const volce::rational volce::rational::operator-() const {
+	rational r(*this);
+	if (r.big) *r.big = -*r.big;
+	else r.n = -r.n;
+	return r;
+}
+
+const int volce::cmp(const rational &a, const rational &b) {
+	if (a.big || b.big) return ::cmp(a.get_q(), b.get_q());
+	__int128 l = (__int128)a.n * b.d;
+	__int128 r = (__int128)b.n * a.d;
+	return (l < r) ? -1 : ((l > r) ? 1 : 0);
+}
+
+const volce::rational volce::rational::num() const {
+	rational r;
+	if (big) r.set(mpq_class(big->get_num()));
+	else r.n = n;
+	return r;
+}
+
+const volce::rational volce::rational::den() const {
+	rational r;
+	if (big) r.set(mpq_class(big->get_den()));
+	else r.n = d;
+	return r;
+}
+
+const volce::rational volce::rational::floor() const {
+	rational r;
+	if (big) {
+		mpz_class z;
+		mpz_fdiv_q(z.get_mpz_t(), big->get_num_mpz_t(), big->get_den_mpz_t());
+		r.set(mpq_class(z));
+	} else {
+		r.n = n / d;
+		if (n % d != 0 && n < 0) r.n--;
+	}
+	return r;
+}
+
+const volce::rational volce::rational::ceil() const {
+	return -(-*this).floor();
+}
+
+const std::string volce::rational::str() const {
+	if (big) return big->get_str();
+	if (d == 1) return std::to_string(n);
+	return std::to_string(n) + "/" + std::to_string(d);
+}
+
+std::size_t volce::hash_value(const rational &r) {
+	if (r.big) return std::hash<std::string>()(r.big->get_str());
+	return std::hash<long>()(r.n) * 31 + std::hash<long>()(r.d);
+}
@@ -0,0 +1,111 @@
+/*  rational.h
+ *
+ *  Copyright (C) 2016-2024 Cunjing Ge.
+ *
+ *  All rights reserved.
+ *
+ *  This file is part of sharpSMT.
+ *  See COPYING for more information on using this software.
+ */
+
+#include <global.h>
+#include <gmpxx.h>
+
+#ifndef RATIONAL_HEADER
+#define RATIONAL_HEADER
+
+namespace volce {
+
+// exact rational number, a fraction of machine integers while they fit, GMP otherwise
+// values are always reduced with a positive denominator, so each has one representation
+class rational {
+public:
+	rational() : n(0), d(1), big(NULL) {};
+	rational(const int v) : n(v), d(1), big(NULL) {};
+	rational(const long v) : n(v), d(1), big(NULL) {};
+	rational(const rational &r) : n(r.n), d(r.d), big(r.big ? new mpq_class(*r.big) : NULL) {};
+	rational(rational &&r) : n(r.n), d(r.d), big(r.big) { r.big = NULL; };
+	~rational() { delete big; };
+
+	//decimal or fraction with an optional sign, e.g., 12, -1.25, 3/4,
+	//throws std::invalid_argument for anything else
+	explicit rational(const std::string &s);
+	//the exact value of a finite double
+	explicit rational(const double v);
+
+	//a number as read by the string constructor, false if s is not one
+	static const bool parse(const std::string &s, rational &r);
+
+	// 2^k
+	static const rational pow2(const unsigned long k);
+
+	rational &operator=(const rational &r) {
+		if (this != &r) {
+			n = r.n; d = r.d;
+			delete big; big = r.big ? new mpq_class(*r.big) : NULL; }
+		return *this; };
+	rational &operator=(rational &&r) {
+		if (this != &r) { n = r.n; d = r.d; delete big; big = r.big; r.big = NULL; }
+		return *this; };
+
+	//arithmetic
+	friend const rational operator+(const rational &a, const rational &b);
+	friend const rational operator-(const rational &a, const rational &b);
+	friend const rational operator*(const rational &a, const rational &b);
+	friend const rational operator/(const rational &a, const rational &b);
+	const rational operator-() const;
+	rational &operator+=(const rational &b) { return *this = *this + b; };
+	rational &operator-=(const rational &b) { return *this = *this - b; };
+	rational &operator*=(const rational &b) { return *this = *this * b; };
+	rational &operator/=(const rational &b) { return *this = *this / b; };
+
+	//comparison
+	friend const int cmp(const rational &a, const rational &b);
+	friend const bool operator==(const rational &a, const rational &b) { return cmp(a, b) == 0; };
+	friend const bool operator!=(const rational &a, const rational &b) { return cmp(a, b) != 0; };
+	friend const bool operator<(const rational &a, const rational &b) { return cmp(a, b) < 0; };
+	friend const bool operator<=(const rational &a, const rational &b) { return cmp(a, b) <= 0; };
+	friend const bool operator>(const rational &a, const rational &b) { return cmp(a, b) > 0; };
+	friend const bool operator>=(const rational &a, const rational &b) { return cmp(a, b) >= 0; };
+	explicit operator bool() const { return big != NULL || n != 0; };
+
+	friend const rational abs(const rational &r) { return (r < 0) ? -r : r; };
+
+	//integer parts
+	const bool is_integer() const { return big ? big->get_den() == 1 : d == 1; };
+	const rational num() const;
+	const rational den() const;
+	const rational floor() const;
+	const rational ceil() const;
+
+	//approximation & printing, fractions are printed as p/q
+	const double get_d() const { return big ? big->get_d() : (double)n / (double)d; };
+	const std::string str() const;
+	friend std::ostream &operator<<(std::ostream &os, const rational &r) { return os << r.str(); };
+
+	//hash for unordered maps
+	friend std::size_t hash_value(const rational &r);
+
+private:
+	// n / d, or *big when big is not NULL
+	long		n;
+	long		d;
+	mpq_class	*big;
+
+	const mpq_class get_q() const;
+
+	//reduce num / den and take machine integers if they fit
+	void set(__int128 num, __int128 den);
+	void set(const mpq_class &q);
+};
+
+const rational operator+(const rational &a, const rational &b);
+const rational operator-(const rational &a, const rational &b);
+const rational operator*(const rational &a, const rational &b);
+const rational operator/(const rational &a, const rational &b);
+const int cmp(const rational &a, const rational &b);
+std::size_t hash_value(const rational &r);
+
+}
+
+#endif
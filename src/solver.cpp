@@ -10,6 +10,9 @@
 
 
 #include <solver.h>
+#include <atomic>
+#include <thread>
+#include <exception>
 
 
 /*
@@ -47,13 +50,43 @@ void volce::solver::z3_init() {
 	for (unsigned int i = 0; i < bop_list.size(); i++)
 		op_expr.push_back(z3_mk_op(i));
 	
+	//index the DAG for evaluation
+	bop_list.build_index(ineq_list.size(), vbool_list.size());
+	bunch_list.init(ineq_list.size() + vbool_list.size());
+	
+	//index the asserts on each key
+	assert_off.assign(bop_list.nkeys() + 1, 0);
+	for (unsigned int i = 0; i < assert_list.size(); i++)
+		if (!assert_list[i].iscbool()) assert_off[bop_list.key(assert_list[i]) + 1]++;
+	for (unsigned int k = 0; k + 1 < assert_off.size(); k++)
+		assert_off[k + 1] += assert_off[k];
+	flat_assert.resize(assert_off.back());
+	std::vector<unsigned int> pos(assert_off.begin(), assert_off.end() - 1);
+	for (unsigned int i = 0; i < assert_list.size(); i++)
+		if (!assert_list[i].iscbool()) flat_assert[pos[bop_list.key(assert_list[i])]++] = i;
+	
+	//independent components are solved by their own z3 solvers
+	decompose();
+	enum_init(enumr, z3context);
+	
 	//add assertions
 	for (unsigned int i = 0; i < assert_list.size(); i++)
-		z3solver.add(z3_mk_expr(assert_list[i]));
+		enumr.z3solvers[comp_assert[i]].add(z3_mk_expr(assert_list[i]));
 	
 	//add inequalities
 	for (unsigned int i = 0; i < ineq_list.size(); i++)
-		z3solver.add(z3_mk_ineq(i));
+		enumr.z3solvers[comp_lit[i]].add(z3_mk_ineq(i));
+	
+	//boolean skeletons, inequalities are free literals here
+	if (enable_bunch && enable_prime) {
+		std::vector<z3::expr_vector> comp_exprs(nComps, z3::expr_vector(z3context));
+		for (unsigned int i = 0; i < assert_list.size(); i++)
+			comp_exprs[comp_assert[i]].push_back(z3_mk_expr(assert_list[i]));
+		for (unsigned int k = 0; k < nComps; k++) {
+			enumr.skel.push_back(z3::solver(z3context));
+			enumr.skel[k].add(!z3::mk_and(comp_exprs[k]));
+		}
+	}
 		
 	z3_init_bounds(wordlength);
 		
@@ -67,10 +100,60 @@ void volce::solver::z3_init_bounds(const int wordlength) {
 
 	//add bounds for variables
 	for (unsigned int i = 0; i < vnum_list.size(); i++) {
-		z3solver.add(vnum_expr[i] <= (int)pow(2, wordlength - 1) - 1);
-		z3solver.add(vnum_expr[i] >= -(int)pow(2, wordlength - 1));
+		enumr.z3solvers[comp_vnum[i]].add(vnum_expr[i] <= (int)pow(2, wordlength - 1) - 1);
+		enumr.z3solvers[comp_vnum[i]].add(vnum_expr[i] >= -(int)pow(2, wordlength - 1));
+	}
+	
+}
+
+// asserts sharing no variables, directly or through inequalities, go to different components,
+// components are numbered by their first assert, constant asserts and unused variables go to the first one
+void volce::solver::decompose() {
+
+	unsigned int nkeys = bop_list.nkeys();
+	unsigned int nineqs = ineq_list.size();
+	
+	comp_assert.assign(assert_list.size(), 0);
+	comp_lit.assign(nineqs + vbool_list.size(), 0);
+	comp_vnum.assign(vnum_list.size(), 0);
+	nComps = 1;
+	
+	if (enable_comp) {
+		//keys of bop_list, then numeric variables
+		std::vector<unsigned int> parent(nkeys + vnum_list.size());
+		for (unsigned int k = 0; k < parent.size(); k++) parent[k] = k;
+		
+		//operators with their children, inequalities with their variables
+		for (unsigned int i = 0; i < bop_list.size(); i++)
+			for (const dagc *c = bop_list.child_begin(i); c != bop_list.child_begin(i) + bop_list.nchildren(i); c++)
+				if (!c->iscbool()) parent[uf_find(parent, bop_list.key(*c))] = uf_find(parent, i);
+		for (unsigned int i = 0; i < nineqs; i++)
+			for (unsigned int j = 0; j < ineq_list[i].size(); j++)
+				parent[uf_find(parent, nkeys + ineq_list[i][j].id)] = uf_find(parent, bop_list.ineq_key(i));
+		
+		std::vector<int> id(parent.size(), -1);
+		nComps = 0;
+		for (unsigned int i = 0; i < assert_list.size(); i++) {
+			if (assert_list[i].iscbool()) continue;
+			unsigned int r = uf_find(parent, bop_list.key(assert_list[i]));
+			if (id[r] < 0) id[r] = nComps++;
+			comp_assert[i] = id[r];
+		}
+		if (nComps == 0) nComps = 1;
+		
+		for (unsigned int i = 0; i < comp_lit.size(); i++) {
+			int c = id[uf_find(parent, (i < nineqs) ? bop_list.ineq_key(i) : bop_list.vbool_key(i - nineqs))];
+			if (c >= 0) comp_lit[i] = c;
+		}
+		for (unsigned int v = 0; v < comp_vnum.size(); v++) {
+			int c = id[uf_find(parent, nkeys + v)];
+			if (c >= 0) comp_vnum[v] = c;
+		}
 	}
 	
+	comp_nvars.assign(nComps, 0);
+	for (unsigned int v = 0; v < comp_vnum.size(); v++)
+		comp_nvars[comp_vnum[v]]++;
 }
 
 
@@ -105,22 +188,10 @@ z3::expr volce::solver::z3_mk_term(const term t) {
 }
 
 
-z3::expr volce::solver::z3_mk_nconst(const double val) {
+z3::expr volce::solver::z3_mk_nconst(const rational &val) {
 
-//	if (islia()) {
-		//int const
-//		return z3context.int_val((int)val);
-//	} else {
-		//real const
-		char num[STRLEN];
-		sprintf(num, "%.8g", val);
-		//remove char '+'
-		for (unsigned int i = 0; num[i] != 0; i++)
-			if (num[i] == '+')
-				while (num[i] != 0)
-					num[i] = num[i + 1], i++;
-		return z3context.real_val(num);
-//	}
+	//exact real const, as an integer or a fraction p/q
+	return z3context.real_val(val.str().c_str());
 
 }
 
@@ -174,68 +245,257 @@ z3::expr volce::solver::z3_mk_expr(const dagc node) {
 }
 
 
+// make an enumerator in context c, the solver's own one is filled by z3_init,
+// others copy its solvers, they must be made before the enumeration starts
+void volce::solver::enum_init(enum_state &es, z3::context &c) {
+
+	es.ctx = &c;
+	es.z3solvers.clear();
+	es.skel.clear();
+	es.ineq_lit.clear();
+	es.vbool_lit.clear();
+	if (&c == &z3context) {
+		for (unsigned int k = 0; k < nComps; k++)
+			es.z3solvers.push_back(z3::solver(c));
+		es.ineq_lit = ineq_expr;
+		es.vbool_lit = vbool_expr;
+	} else {
+		for (unsigned int k = 0; k < nComps; k++)
+			es.z3solvers.push_back(z3::solver(c, enumr.z3solvers[k], z3::solver::translate()));
+		for (unsigned int k = 0; k < enumr.skel.size(); k++)
+			es.skel.push_back(z3::solver(c, enumr.skel[k], z3::solver::translate()));
+		for (unsigned int i = 0; i < ineq_list.size(); i++)
+			es.ineq_lit.push_back(c.bool_const(ineq_list.name(i).c_str()));
+		for (unsigned int i = 0; i < vbool_list.size(); i++)
+			es.vbool_lit.push_back(c.bool_const(vbool_list.name(i).c_str()));
+	}
+	
+	es.comp = 0;
+	es.fixed.clear();
+	es.eval_heap.clear();
+	es.eval_queued.assign(bop_list.size(), false);
+	enum_reset(es);
+}
+
+// forget the bunches of the enumerator, for the next component or cube
+void volce::solver::enum_reset(enum_state &es) {
+
+	es.bunches.init(ineq_list.size() + vbool_list.size());
+	es.bunch_post.clear();
+	es.bunch_conflicts.clear();
+}
+
 // repeatable smt solving
 // true: achieve a feasible bunch
 // false: unsat
 const bool volce::solver::solve() {
 
-	// check, return false if unsat
+	// the formula is unsat if any component is, so all are checked before the first bunch
+	if (nComps > 1 && bunch_list.size() == 0 && enumr.comp == 0)
+		for (unsigned int c = 0; c < nComps; c++)
+			if (enumr.z3solvers[c].check() != z3::sat) {
+				enumr.comp = nComps;
+				return false;
+			}
+	
+	// move to the next component if unsat, return false if all are done
+	while (enumr.comp < nComps) {
+		enumr.cube = enumr.comp;
+		if (next_bunch(enumr)) return true;
+		enumr.comp++;
+		enum_reset(enumr);
+	}
+	return false;
+	
+}
+
+// cube-and-conquer, each component is split into cubes over its literals with most parents,
+// each thread enumerates the cubes it takes with its own z3 context,
+// the literals of the cube stay decided in its bunches, so bunches of different cubes are disjoint
+void volce::solver::solve(const unsigned int nthreads, const std::function<bool(unsigned int)> &found) {
+
+	if (nthreads <= 1) {
+		while (solve()) 
+			if (!found(enumr.last)) return;
+		return;
+	}
+	
+	// the formula is unsat if any component is
+	for (unsigned int c = 0; c < nComps; c++)
+		if (enumr.z3solvers[c].check() != z3::sat) return;
+	
+	// bunches never merge across cubes, each literal of the cubes may double them, 
+	// so components are split into about 2 cubes for each thread in all, not more
+	unsigned int nbits = 0;
+	while ((nComps << nbits) < 2 * nthreads && nbits < 10) nbits++;
+	
+	// cubes of literals at 2 * pos + val
+	std::vector<std::pair<unsigned int, std::vector<unsigned int>>> cubes;
+	for (unsigned int c = 0; c < nComps; c++) {
+		std::vector<unsigned int> lits;
+		select_cube(c, nbits, lits);
+		for (unsigned int mask = 0; mask < (1u << lits.size()); mask++) {
+			std::vector<unsigned int> cube;
+			for (unsigned int j = 0; j < lits.size(); j++)
+				cube.push_back(2 * lits[j] + ((mask >> j) & 1));
+			cubes.push_back(std::make_pair(c, cube));
+		}
+	}
+	
+	// z3 contexts are not thread safe, the copies are made here
+	std::vector<std::unique_ptr<enum_state>> states;
+	for (unsigned int t = 0; t < nthreads; t++) {
+		states.push_back(std::unique_ptr<enum_state>(new enum_state()));
+		states[t]->own_ctx.reset(new z3::context());
+		enum_init(*states[t], *states[t]->own_ctx);
+	}
+	
+	//a refused bunch or the first exception stops all threads, 
+	//the exception is rethrown once they are joined
+	std::atomic<unsigned int> next(0);
+	std::atomic<bool> stop(false);
+	std::exception_ptr error;
+	std::mutex error_mutex;
+	std::vector<std::thread> threads;
+	for (unsigned int t = 0; t < nthreads; t++)
+		threads.push_back(std::thread([this, &states, &cubes, &next, &stop, &error, &error_mutex, &found, t]() {
+			enum_state &es = *states[t];
+			unsigned int k;
+			try {
+				while (!stop && (k = next++) < cubes.size()) {
+					es.comp = cubes[k].first;
+					es.fixed = cubes[k].second;
+					es.cube = k;
+					z3::solver &z3solver = es.z3solvers[es.comp];
+					z3solver.push();
+					for (unsigned int j = 0; j < es.fixed.size(); j++) {
+						unsigned int pos = es.fixed[j] / 2;
+						z3::expr lit = (pos < ineq_list.size()) ? es.ineq_lit[pos] : es.vbool_lit[pos - ineq_list.size()];
+						z3solver.add((es.fixed[j] & 1) ? lit : !lit);
+					}
+					enum_reset(es);
+					while (!stop && next_bunch(es))
+						if (!found(es.last)) stop = true;
+					z3solver.pop();
+				}
+			} catch (...) {
+				std::lock_guard<std::mutex> lock(error_mutex);
+				if (!error) error = std::current_exception();
+				stop = true;
+			}
+		}));
+	for (unsigned int t = 0; t < nthreads; t++)
+		threads[t].join();
+	if (error) std::rethrow_exception(error);
+		
+}
+
+void volce::solver::bunch_order(std::vector<unsigned int> &order) {
+
+	std::lock_guard<std::mutex> lock(bunch_mutex);
+	order.resize(bunch_list.size());
+	for (unsigned int i = 0; i < order.size(); i++) order[i] = i;
+	std::sort(order.begin(), order.end(), 
+		[this](unsigned int x, unsigned int y) { return rank_bunch[x] < rank_bunch[y]; });
+}
+
+// at most nbits literals of the component, which have most parents and asserts
+void volce::solver::select_cube(const unsigned int comp, const unsigned int nbits, std::vector<unsigned int> &lits) {
+
+	unsigned int nineqs = ineq_list.size();
+	std::vector<std::pair<unsigned int, unsigned int>> cand;
+	for (unsigned int pos = 0; pos < nineqs + vbool_list.size(); pos++) {
+		if (comp_lit[pos] != comp) continue;
+		unsigned int k = (pos < nineqs) ? bop_list.ineq_key(pos) : bop_list.vbool_key(pos - nineqs);
+		unsigned int f = (bop_list.fanout_end(k) - bop_list.fanout_begin(k)) + (assert_off[k + 1] - assert_off[k]);
+		if (f > 0) cand.push_back(std::make_pair(f, pos));
+	}
+	std::sort(cand.begin(), cand.end(), [](const std::pair<unsigned int, unsigned int> &a, 
+											const std::pair<unsigned int, unsigned int> &b) {
+		return a.first > b.first || (a.first == b.first && a.second < b.second); });
+	
+	lits.clear();
+	for (unsigned int i = 0; i < cand.size() && i < nbits; i++)
+		lits.push_back(cand[i].second);
+}
+
+// the next bunch of es.comp within the cube of es
+// true: achieve a feasible bunch, stored in bunch_list at es.last
+// false: unsat
+const bool volce::solver::next_bunch(enum_state &es) {
+
+	z3::solver &z3solver = es.z3solvers[es.comp];
 	if (z3solver.check() != z3::sat) return false;
 	
 	// extract the model
 	z3::model z3model = z3solver.get_model();
 	
 	//init with -1
-	ineq_list.init_vals();
-	vbool_list.init_vals();
+	es.ineq_val.assign(ineq_list.size(), dagv());
+	es.vbool_val.assign(vbool_list.size(), dagv());
 	
-	// scan and extract the partial assignments
-	for (unsigned int i = 0; i < z3model.size(); i++){
-		z3::func_decl var = z3model[i];
-		
-		// model presented by z3 doesnt contain unknown assignments
-		// first, check whether it is an inequality by name
-		unsigned int id = ineq_list.find(var.name().str());
-		if (id != ineq_list.size()) {
-			// inequalities
-			// set ineq val
-			ineq_list(id) = dagv(eq(z3model.get_const_interp(var), z3context.bool_val(true)));
-		} else {
-			// then, check whether it is a pure bool variable by name
-			id = vbool_list.find(var.name().str());
-			if (id != vbool_list.size())
-				vbool_list(id) = dagv(eq(z3model.get_const_interp(var), z3context.bool_val(true)));
-		}
+	// read the partial assignments of the literals directly
+	// model presented by z3 doesnt contain unknown assignments, 
+	// without model completion they evaluate to themselves
+	for (unsigned int i = 0; i < ineq_list.size(); i++) {
+		if (comp_lit[i] != es.comp) continue;
+		z3::expr v = z3model.eval(es.ineq_lit[i]);
+		if (v.is_true()) es.ineq_val[i] = dagv(true);
+		else if (v.is_false()) es.ineq_val[i] = dagv(false);
+	}
+	for (unsigned int i = 0; i < vbool_list.size(); i++) {
+		if (comp_lit[ineq_list.size() + i] != es.comp) continue;
+		z3::expr v = z3model.eval(es.vbool_lit[i]);
+		if (v.is_true()) es.vbool_val[i] = dagv(true);
+		else if (v.is_false()) es.vbool_val[i] = dagv(false);
+	}
+	
+	// literals of the cube are decided even if z3 leaves them out
+	for (unsigned int j = 0; j < es.fixed.size(); j++) {
+		unsigned int pos = es.fixed[j] / 2;
+		if (pos < ineq_list.size()) es.ineq_val[pos] = dagv((bool)(es.fixed[j] & 1));
+		else es.vbool_val[pos - ineq_list.size()] = dagv((bool)(es.fixed[j] & 1));
 	}
 
 	if (enable_bunch) {
+	
+		// evaluate the DAG under the model once, flips are evaluated incrementally
+		eval_init(es);
 
 		// try to reduce the solution into a bunch
 		std::vector<bool> ineq_flip(ineq_list.size(), true);
 		for (unsigned int i = 0; i < ineq_list.size(); i++)
-			if (ineq_list(i).is_unknown()) 
+			if (es.ineq_val[i].is_unknown()) 
 				ineq_flip[i] = false;
 		std::vector<bool> vbool_flip(vbool_list.size(), true);
 		for (unsigned int i = 0; i < vbool_list.size(); i++)
-			if (vbool_list(i).is_unknown()) 
+			if (es.vbool_val[i].is_unknown()) 
 				vbool_flip[i] = false;
+		for (unsigned int j = 0; j < es.fixed.size(); j++) {
+			unsigned int pos = es.fixed[j] / 2;
+			if (pos < ineq_list.size()) ineq_flip[pos] = false;
+			else vbool_flip[pos - ineq_list.size()] = false;
+		}
+		
+		// flips that lead to similar bunches, updated while literals are reduced
+		get_flip_list(es, ineq_flip, vbool_flip);
 		
 GOTO_BUNCH_CYCLE:
-	
-		get_flip_list(ineq_flip, vbool_flip);
 
 		for (unsigned int i = 0; i < vbool_list.size(); i++) {
 			// skip vbool should not be flipped
 			if (!vbool_flip[i]) continue;
 
-			vbool_list(i).negate();
-			if (get_result()) {
+			const dagv old = es.vbool_val[i];
+			set_vbool(es, i, !old);
+			if (get_result(es)) {
 				// reduce i-th vbool and start next round
-				vbool_list(i) = dagv();
+				set_vbool(es, i, dagv());
 				vbool_flip[i] = false;
+				update_flip_list(es, ineq_list.size() + i, old, ineq_flip, vbool_flip);
 				goto GOTO_BUNCH_CYCLE;
 			} else {
-				vbool_list(i).negate();
+				set_vbool(es, i, old);
 			}
 		}
 		
@@ -243,18 +503,23 @@ GOTO_BUNCH_CYCLE:
 			// skip ineq should not be flipped
 			if (!ineq_flip[i]) continue;
 		
-			ineq_list(i).negate();
-			if (get_result()) {
+			const dagv old = es.ineq_val[i];
+			set_ineq(es, i, !old);
+			if (get_result(es)) {
 				// reduce i-th ineq and start next round
-				ineq_list(i) = dagv();
+				set_ineq(es, i, dagv());
 				ineq_flip[i] = false;
+				update_flip_list(es, i, old, ineq_flip, vbool_flip);
 				goto GOTO_BUNCH_CYCLE;
 			} else {
-				ineq_list(i).negate();
+				set_ineq(es, i, old);
 			}
 		}
 
 		// no more var can be flipped
+		
+		// literals the three-valued evaluation cannot drop
+		if (enable_prime) prime_bunch(es, ineq_flip, vbool_flip);
 	
 	}
 	
@@ -357,74 +622,148 @@ GOTO_BUNCH_CYCLE:
 	std::cout << std::endl << std::endl;
 */	
 	// store bunches
-	bunch_elem bunch(ineq_list, vbool_list);
-	bunch_list.push_back(bunch);
+	bsol bunch = cur_bunch(es);
 	
-	// multipliers = 2^(the number of unassigned bools)
-	unsigned int m = 1;
+	// multipliers = 2^(the number of unassigned bools of the component), the exponent is kept
+	unsigned int m = 0;
 	for (unsigned int i = 0; i < vbool_list.size(); i++) {
-		if (vbool_list(i).is_unknown()) m *= 2;
+		if (es.vbool_val[i].is_unknown() && comp_lit[ineq_list.size() + i] == es.comp) m++;
 	}
-	multiplier.push_back(m);
 	
-	// note: nFormulas = ineq_list.size()
-	int *sol = new int[nFormulas];
-	for (unsigned int i = 0; i < nFormulas; i++) {
-		if (ineq_list(i).is_true()) sol[i] = 1;
-		else if (ineq_list(i).is_false()) sol[i] = 0;
-		else sol[i] = -1;
-		//std::cout << sol[i] << " ";
-	}
-	//std::cout << std::endl;
-	bsols.push_back(sol);
+	// workers and other enumerators may access bunches during enumeration
+	std::unique_lock<std::mutex> lock(bunch_mutex);
+	bunch_list.push_back(bunch);
+	multiplier.push_back(m);
+	comp_bunch.push_back(es.comp);
+	rank_bunch.push_back(std::make_pair(es.cube, es.bunches.size()));
+	es.last = bunch_list.size() - 1;
+	lock.unlock();
+	es.bunches.push_back(bunch);
+	index_bunch(es, es.bunches.size() - 1);
 
 	//print_model(); std::cout << std::endl;
 
-	//negate the model and add into solver
-	z3::expr new_assert = z3context.bool_val(false);
+	//negate the bunch and add into solver, as one flat clause over its decided literals
+	z3::expr_vector block(*es.ctx);
 	for (unsigned int i = 0; i < vbool_list.size(); i++) {
-		const dagv val = vbool_list(i);
+		const dagv val = es.vbool_val[i];
 		if (val.is_unknown()) continue;
-		else if (val.is_true()) new_assert = (new_assert || !vbool_expr[i]);
-		else new_assert = (new_assert || vbool_expr[i]);
+		block.push_back(val.is_true() ? !es.vbool_lit[i] : es.vbool_lit[i]);
 	}
 	for (unsigned int i = 0; i < ineq_list.size(); i++) {
-		const dagv val = ineq_list(i);
+		const dagv val = es.ineq_val[i];
 		if (val.is_unknown()) continue;
-		else if (val.is_true()) new_assert = (new_assert || !ineq_expr[i]);
-		else new_assert = (new_assert || ineq_expr[i]);
+		block.push_back(val.is_true() ? !es.ineq_lit[i] : es.ineq_lit[i]);
 	}
-	z3solver.add(new_assert);
+	//empty for a bunch covering the whole component, then it is false
+	z3solver.add(z3::mk_or(block));
 	
 	return true;
 	
 }
 
-const bool volce::solver::get_result() {
-	bop_list.init_vals();
+void volce::solver::op_vec::build_index(const unsigned int nineqs, const unsigned int nvbools) {
+
+	nineq = nineqs;
+	
+	//flat children
+	child_off.assign(1, 0);
+	flat_child.clear();
+	for (unsigned int i = 0; i < size(); i++) {
+		flat_child.insert(flat_child.end(), ops[i].begin(), ops[i].end());
+		child_off.push_back(flat_child.size());
+	}
+	
+	//count fanouts of each key, then fill
+	fanout_off.assign(size() + nineqs + nvbools + 1, 0);
+	for (unsigned int i = 0; i < flat_child.size(); i++)
+		if (!flat_child[i].iscbool()) fanout_off[key(flat_child[i]) + 1]++;
+	for (unsigned int k = 0; k + 1 < fanout_off.size(); k++)
+		fanout_off[k + 1] += fanout_off[k];
+	
+	flat_fanout.resize(flat_child.size());
+	std::vector<unsigned int> pos(fanout_off.begin(), fanout_off.end() - 1);
+	for (unsigned int i = 0; i < size(); i++)
+		for (unsigned int j = child_off[i]; j < child_off[i + 1]; j++)
+			if (!flat_child[j].iscbool()) flat_fanout[pos[key(flat_child[j])]++] = i;
+}
+
+// evaluate all operators and asserts with current values of variables
+void volce::solver::eval_init(enum_state &es) {
+
+	es.op_val.assign(bop_list.size(), dagv());
 	for (unsigned int i = 0; i < bop_list.size(); i++)
-		bop_list(i) = eval_op(i);
-	for (unsigned int i = 0; i < assert_list.size(); i++)
-		if (!get_val(assert_list[i]).is_true()) 
-			return false;
-	return true;
+		es.op_val[i] = eval_op(es, i);
+		
+	es.eval_unsat = 0;
+	es.assert_sat.assign(assert_list.size(), false);
+	for (unsigned int i = 0; i < assert_list.size(); i++) {
+		es.assert_sat[i] = get_val(es, assert_list[i]).is_true();
+		//asserts of other components are left unknown
+		if (!es.assert_sat[i] && comp_assert[i] == es.comp) es.eval_unsat++;
+	}
+}
+
+// assign a variable, then evaluate affected operators in topological order,
+// children of an operator always have smaller indices
+void volce::solver::eval_assign(enum_state &es, const unsigned int key, dagv &var, const dagv val) {
+
+	if (var == val) return;
+	var = val;
+	
+	//the key of a variable is larger than any operator
+	unsigned int k = key;
+	while (true) {
+		//update asserts on the node
+		for (unsigned int j = assert_off[k]; j < assert_off[k + 1]; j++) {
+			unsigned int a = flat_assert[j];
+			bool sat = get_val(es, assert_list[a]).is_true();
+			if (sat != es.assert_sat[a]) {
+				es.assert_sat[a] = sat;
+				if (sat) es.eval_unsat--;
+				else es.eval_unsat++;
+			}
+		}
+		
+		//queue parents
+		for (const unsigned int *p = bop_list.fanout_begin(k); p != bop_list.fanout_end(k); p++)
+			if (!es.eval_queued[*p]) {
+				es.eval_queued[*p] = true;
+				es.eval_heap.push_back(*p);
+				std::push_heap(es.eval_heap.begin(), es.eval_heap.end(), std::greater<unsigned int>());
+			}
+		
+		//evaluate the next changed operator
+		do {
+			if (es.eval_heap.empty()) return;
+			std::pop_heap(es.eval_heap.begin(), es.eval_heap.end(), std::greater<unsigned int>());
+			k = es.eval_heap.back();
+			es.eval_heap.pop_back();
+			es.eval_queued[k] = false;
+			
+			dagv v = eval_op(es, k);
+			if (v == es.op_val[k]) k = bop_list.nkeys();
+			else es.op_val[k] = v;
+		} while (k == bop_list.nkeys());
+	}
 }
 
-const volce::solver::dagv volce::solver::eval_op(const unsigned int index) {
+const volce::solver::dagv volce::solver::eval_op(const enum_state &es, const unsigned int index) const {
 	// may return unknown even if the formula can be evaluated
 	// a: false, b: false, c: unknown
 	// (and (or -c a) (or c b)) = false
 	// (or -c a) = unknown, (or c b) = unknown, (and unknown unknown) = unknown
 
 	const dagc node(bop_list.type(index), index);
-	const std::vector<dagc> c = bop_list[index];
+	const dagc *c = bop_list.child_begin(index);
+	const unsigned int n = bop_list.nchildren(index);
 	
 	//nodes of propositional operators
 	if (node.isand()) {
 		//AND
 		bool is_unkwn = false;
- 		for (unsigned int i = 0; i < c.size(); i++) {
- 			dagv val = get_val(c[i]);
+ 		for (unsigned int i = 0; i < n; i++) {
+ 			dagv val = get_val(es, c[i]);
  			if (val.is_false()) return dagv(false);
  			else if (val.is_unknown()) is_unkwn = true;
  		}
@@ -433,8 +772,8 @@ const volce::solver::dagv volce::solver::eval_op(const unsigned int index) {
 	} else if (node.isor()) {
 		//OR
 		bool is_unkwn = false;
-		for (unsigned int i = 0; i < c.size(); i++) {
-			dagv val = get_val(c[i]);
+		for (unsigned int i = 0; i < n; i++) {
+			dagv val = get_val(es, c[i]);
 			if (val.is_true()) return dagv(true);
 			else if (val.is_unknown()) is_unkwn = true;
 		}
@@ -442,15 +781,15 @@ const volce::solver::dagv volce::solver::eval_op(const unsigned int index) {
 		else return dagv(false);
 	} else if (node.iscomp()) {
 		//EQUAL
-		dagv val_l = get_val(c[0]);
-		dagv val_r = get_val(c[1]);
+		dagv val_l = get_val(es, c[0]);
+		dagv val_r = get_val(es, c[1]);
 		if (val_l.is_unknown() || val_r.is_unknown()) return dagv();
 		else return dagv(val_l.is_true() == val_r.is_true());
 	} else if (node.isitebool()) {
 		//ITE
-		dagv val_c = get_val(c[0]);
-		dagv val_l = get_val(c[1]);
-		dagv val_r = get_val(c[2]);
+		dagv val_c = get_val(es, c[0]);
+		dagv val_l = get_val(es, c[1]);
+		dagv val_r = get_val(es, c[2]);
 		if (val_c.is_true()) {
 			//(ite true l r) -> l
 			return val_l;
@@ -468,95 +807,161 @@ const volce::solver::dagv volce::solver::eval_op(const unsigned int index) {
 
 }
 
-const volce::solver::dagv volce::solver::get_val(const dagc node) {
+const volce::solver::dagv volce::solver::get_val(const enum_state &es, const dagc node) const {
 
 	if (node.iscbool()) {
 		//constant: true or false
 		return dagv(node.bval());
 	} else if (node.isvbool()) {
 		//boolean variable
-		return (node.isneg()) ? !vbool_list(node.id) : vbool_list(node.id);
+		return (node.isneg()) ? !es.vbool_val[node.id] : es.vbool_val[node.id];
 	} else if (node.isineq()) {
 		//ineq variable
-		return (node.isneg()) ? !ineq_list(node.id) : ineq_list(node.id);
+		return (node.isneg()) ? !es.ineq_val[node.id] : es.ineq_val[node.id];
 	} else if (node.isboolop()) {
 		//boolean operator
-		return (node.isneg()) ? !bop_list(node.id) : bop_list(node.id);
+		return (node.isneg()) ? !es.op_val[node.id] : es.op_val[node.id];
 	} else assert(false);
 
 }
 
 // method for bunch strategy
-// input: ineq_list and vbool_list
+// input: values of ineqs and vbools in es
 // output: ineqs and vbools which should be flipped
-void volce::solver::get_flip_list(std::vector<bool> &ineq_flip, std::vector<bool> &vbool_flip)
+void volce::solver::get_flip_list(enum_state &es, std::vector<bool> &ineq_flip, std::vector<bool> &vbool_flip)
 {
 	
-	//ineq_flip.clear();
-	//ineq_flip.resize(ineq_list.size(), true);
-	
-	//vbool_flip.clear();
-	//vbool_flip.resize(vbool_list.size(), true);
+	es.flip_cur = cur_bunch(es);
+	es.bunch_conflicts.assign(es.bunches.size(), 0);
+	es.bunch_post.resize(2 * (ineq_list.size() + vbool_list.size()));
 	
-	//check all previous bunches
-	for (unsigned int i = 0; i < bunch_list.size(); i++) {
-		
-		bunch_elem &prev_bunch = bunch_list[i];
+	//check all previous bunches of the enumerator, count decided literals with different values
+	//the counts are kept exact over all words, update_flip_list only decrements them
+	for (unsigned int i = 0; i < es.bunches.size(); i++) {
+		const uint64_t *known = es.bunches.known(i);
+		const uint64_t *value = es.bunches.value(i);
 		
 		unsigned int differ_count = 0;
-		int ineq_id = -1;
-		int vbool_id = -1;
-		
-		// check ineq_val
-		// ineq_list.size() == target.ineq_val.size() == prev_bunch.ineq_val.size()
-		for (unsigned int j = 0; j < ineq_list.size() && differ_count <= 1; j++) {
+		for (unsigned int w = 0; w < es.flip_cur.nwords(); w++)
+			differ_count += __builtin_popcountll(known[w] & es.flip_cur.known()[w] & 
+									(value[w] ^ es.flip_cur.value()[w]));
 		
-			if (ineq_list(j).is_unknown() || prev_bunch.ineq_vals[j].is_unknown()) {
-				// skip unknown, treat as equal value
-				continue;
-			} else if (ineq_list(j).is_true() != prev_bunch.ineq_vals[j].is_true()) {
-				// differ value found
-				if (differ_count == 1) 
-					goto GOTO_NEXT_BUNCH;
-				else {
-					differ_count++;
-					ineq_id = j;
-				}
-			}
-		}
-		
-		// check vbool_val
-		// vbool_list.size() == target.vbool_val.size() == prev_bunch.vbool_val.size()
-		for (unsigned int j = 0; j < vbool_list.size() && differ_count <= 1; j++) {
-		
-			if (vbool_list(j).is_unknown() || prev_bunch.vbool_vals[j].is_unknown()) {
-				// skip unknown, treat as equal value
-				continue;
-			} else if (vbool_list(j).is_true() != prev_bunch.vbool_vals[j].is_true()) {
-				// differ value found
-				if (differ_count == 1) 
-					goto GOTO_NEXT_BUNCH;
-				else {
-					differ_count++;
-					vbool_id = j;
-				}
-			}
-		}
-		
-		assert(differ_count == 1);
-		assert(ineq_id >= 0 || vbool_id >= 0);
-		assert(ineq_id < 0 || vbool_id < 0);
+		es.bunch_conflicts[i] = differ_count;
 		
 		// a similar bunch found, set dangerous flip
-		if (ineq_id >= 0) {
-			ineq_flip[ineq_id] = false;
-		} else {
-			vbool_flip[vbool_id] = false;
-		} 
+		assert(differ_count >= 1);
+		if (differ_count == 1) mark_flip(es, i, ineq_flip, vbool_flip);
+	}
+}
+
+// the literal at pos turns unknown, so only bunches deciding the opposite value
+// may get closer to the current assignment
+void volce::solver::update_flip_list(enum_state &es, const unsigned int pos, const dagv old, 
+								std::vector<bool> &ineq_flip, std::vector<bool> &vbool_flip)
+{
+	es.flip_cur.set(pos, -1);
+	
+	const std::vector<unsigned int> &post = es.bunch_post[2 * pos + (old.is_true() ? 0 : 1)];
+	for (unsigned int k = 0; k < post.size(); k++) {
+		unsigned int i = post[k];
+		// bunches with a single different literal are marked already
+		if (es.bunch_conflicts[i] <= 1) continue;
+		if (--es.bunch_conflicts[i] == 1) mark_flip(es, i, ineq_flip, vbool_flip);
+	}
+}
+
+// set the only different literal of a similar bunch as dangerous flip
+void volce::solver::mark_flip(enum_state &es, const unsigned int index, std::vector<bool> &ineq_flip, std::vector<bool> &vbool_flip)
+{
+	const uint64_t *known = es.bunches.known(index);
+	const uint64_t *value = es.bunches.value(index);
+	
+	for (unsigned int w = 0; w < es.flip_cur.nwords(); w++) {
+		uint64_t differ = known[w] & es.flip_cur.known()[w] & (value[w] ^ es.flip_cur.value()[w]);
+		if (differ == 0) continue;
 		
-GOTO_NEXT_BUNCH:;
+		unsigned int pos = w * 64 + __builtin_ctzll(differ);
+		if (pos < ineq_list.size()) ineq_flip[pos] = false;
+		else vbool_flip[pos - ineq_list.size()] = false;
+		return;
+	}
+	assert(false);
+}
+
+// add a new bunch into the posting lists of its literals
+void volce::solver::index_bunch(enum_state &es, const unsigned int index)
+{
+	unsigned int nlits = es.bunches.nlits();
+	
+	es.bunch_post.resize(2 * nlits);
+	for (unsigned int pos = 0; pos < nlits; pos++)
+		if (es.bunches.is_known(index, pos)) 
+			es.bunch_post[2 * pos + (es.bunches.is_true(index, pos) ? 1 : 0)].push_back(index);
+}
+
+// try the remaining flips by z3, a literal is dropped if the others still imply the asserts 
+// of the component for any values of unknown literals, literals not in the last unsat core 
+// are dropped without checks, the result is prime except for the literals keeping bunches disjoint
+void volce::solver::prime_bunch(enum_state &es, std::vector<bool> &ineq_flip, std::vector<bool> &vbool_flip)
+{
+	unsigned int nineqs = ineq_list.size();
+	unsigned int nlits = nineqs + vbool_list.size();
+	
+	std::vector<bool> in_core(nlits, false);
+	if (!skel_core(es, nlits, in_core)) return;
+	
+	for (unsigned int pos = 0; pos < nlits; pos++) {
+		std::vector<bool>::reference flip = (pos < nineqs) ? ineq_flip[pos] : vbool_flip[pos - nineqs];
+		if (!flip) continue;
 		
+		flip = false;
+		if (in_core[pos] && !skel_core(es, pos, in_core)) continue;
+		
+		dagv &val = (pos < nineqs) ? es.ineq_val[pos] : es.vbool_val[pos - nineqs];
+		const dagv old = val;
+		val = dagv();
+		update_flip_list(es, pos, old, ineq_flip, vbool_flip);
+	}
+}
+
+// check the decided literals except skip against the negated skeleton
+// true: unsat, the literals in the core are marked
+// false: sat, the literals do not imply the asserts
+const bool volce::solver::skel_core(enum_state &es, const unsigned int skip, std::vector<bool> &in_core)
+{
+	unsigned int nineqs = ineq_list.size();
+	
+	z3::expr_vector assumptions(*es.ctx);
+	boost::unordered_map<unsigned int, unsigned int> pos_of;
+	for (unsigned int pos = 0; pos < in_core.size(); pos++) {
+		if (pos == skip) continue;
+		const dagv val = (pos < nineqs) ? es.ineq_val[pos] : es.vbool_val[pos - nineqs];
+		if (val.is_unknown()) continue;
+		const z3::expr &lit = (pos < nineqs) ? es.ineq_lit[pos] : es.vbool_lit[pos - nineqs];
+		z3::expr a = val.is_true() ? lit : !lit;
+		assumptions.push_back(a);
+		pos_of[a.id()] = pos;
 	}
+	
+	z3::solver &skel = es.skel[es.comp];
+	if (skel.check(assumptions) != z3::unsat) return false;
+	
+	z3::expr_vector core = skel.unsat_core();
+	in_core.assign(in_core.size(), false);
+	for (unsigned int i = 0; i < core.size(); i++)
+		in_core[pos_of[core[i].id()]] = true;
+	return true;
+}
+
+// the current (partial) assignment, ineqs first, then boolean variables
+const volce::bsol volce::solver::cur_bunch(const enum_state &es) const
+{
+	bsol b(ineq_list.size() + vbool_list.size());
+	for (unsigned int i = 0; i < ineq_list.size(); i++)
+		if (!es.ineq_val[i].is_unknown()) b.set(i, es.ineq_val[i].is_true());
+	for (unsigned int i = 0; i < vbool_list.size(); i++)
+		if (!es.vbool_val[i].is_unknown()) b.set(ineq_list.size() + i, es.vbool_val[i].is_true());
+	return b;
 }
 					
 					
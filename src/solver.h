@@ -10,9 +10,17 @@
 
 #include <global.h>
 #include <ineq.h>
+#include "bigvol.h"
 #include <z3++.h>
 #include "polytope.h"
+#include "bunch.h"
+#include "cache.h"
 #include <boost/math/distributions/normal.hpp>
+#include <mutex>
+#include <memory>
+#include <unordered_map>
+#include <functional>
+#include <stdexcept>
 
 #define NDEBUG
 
@@ -82,18 +90,24 @@ enum NODE_TYPE {
 	NT_ADD, NT_MUL, NT_DIV
 };
 
+// volume & lattice engines, each one keeps its own reusing map
+enum VOL_ENGINE {
+	ENG_LATTE, ENG_BARVINOK, ENG_ALC, ENG_VINCI, ENG_V2L, 
+	ENG_NUM
+};
+
 class VOL_RES_CLS {
 public:
 	//attribute
-	double value;
-	double upper;
-	double lower;
+	bigvol value;
+	bigvol upper;
+	bigvol lower;
 	
 	//method
 	VOL_RES_CLS() { value = 0; upper = 0; lower = 0; };
-	VOL_RES_CLS(double v, double u, double l) {
+	VOL_RES_CLS(bigvol v, bigvol u, bigvol l) {
 		if (v < 0) std::cout << v << std::endl;
-		assert(v >= 0);
+		assert(!(v < 0));
 		value = v;
 		if (u < 0) upper = 0;
 		else upper = u;
@@ -104,18 +118,91 @@ public:
 	const VOL_RES_CLS operator+(const VOL_RES_CLS v) const {
 		return VOL_RES_CLS(value + v.value, upper + v.upper, lower + v.lower);
 	};
-	const VOL_RES_CLS operator+(const double c) const {
+	const VOL_RES_CLS operator+(const bigvol c) const {
 		return VOL_RES_CLS(value + c, upper + c, lower + c);
 	};
 	
 	const VOL_RES_CLS operator*(const VOL_RES_CLS v) const {
 		return VOL_RES_CLS(value * v.value, upper * v.upper, lower * v.lower);
 	};
-	const VOL_RES_CLS operator*(const double c) const {
+	const VOL_RES_CLS operator*(const bigvol c) const {
 		return VOL_RES_CLS(value * c, upper * c, lower * c);
 	};
 };
 
+// a global error raised while computing a bunch, workers throw it 
+// and the main thread reports it and exits with the status
+class global_error : public std::runtime_error {
+public:
+	global_error(const std::string &msg, const int code) : std::runtime_error(msg), status(code) {};
+	
+	const int status;
+};
+
+// scratch state of the volume & lattice routines
+// every worker owns one, so that bunches can be computed in parallel
+class vol_scratch {
+public:
+	//submatrix of the current call
+	arma::mat		matA;		// submat A for volume routines
+	arma::vec		colb;		// subcol B for volume routines
+	std::vector<int> rowop;		// op of each row
+	
+	//private dir for temp files of external tools, e.g., latte, alc
+	std::string		workdir;	// created on first use, empty before
+	
+	//exact copy of matA & colb for counting, row-major, kept when exact is set
+	bool			exact;
+	std::vector<rational> exA;
+	std::vector<rational> exb;
+	
+	//column of each variable in matA
+	std::vector<int> colmap;
+	
+	//rows of matA for redundancy check, linked by the classes of their rows
+	std::vector<int> cls_head;	// last row of each class, -1 for none
+	std::vector<int> cls_next;	// previous row of the same class
+	std::vector<unsigned int> cls_row;	// row of the inequality (or bound) of each row
+	
+	//canonical key of the current system, for reusing results
+	key128			key;
+	
+	//chains of PolyVest random walks, run on threads of their own
+	unsigned int	chains;
+	
+	//bounding box of the current system by bound_computation, and the center
+	//of its extreme points, valid once all bounds are solved
+	bool			box_valid;
+	std::vector<double> box_max;
+	std::vector<double> box_min;
+	arma::vec		box_center;
+	
+	//statistics since the last merge into the solver
+	unsigned int stats_vol_calls;
+	unsigned int stats_vol_reuses;
+	unsigned int stats_total_dims;
+	unsigned int stats_max_dims;
+	unsigned int stats_fact_bunches;
+	unsigned int stats_ge_vars;		// variables eliminated by Gauss elimination
+	
+	vol_scratch() : exact(false), chains(1), box_valid(false) { reset_stats(); };
+	vol_scratch(const vol_scratch &) = delete;
+	vol_scratch &operator=(const vol_scratch &) = delete;
+	~vol_scratch() { remove_workdir(); };
+	
+	const bool make_workdir();
+	void remove_workdir();
+	
+	void reset_stats() {
+		stats_vol_calls = 0;
+		stats_vol_reuses = 0;
+		stats_total_dims = 0;
+		stats_max_dims = 0;
+		stats_fact_bunches = 0;
+		stats_ge_vars = 0;
+	};
+};
+
 /*
 	main class --- solver
 */
@@ -134,10 +221,10 @@ public:
 	public:
 		NODE_TYPE		t;
 		unsigned int	id;
-		double			v;
-		double			m;	//for bool, 1 = not negated, -1 = negated
+		rational		v;
+		rational		m;	//for bool, 1 = not negated, -1 = negated
 	
-		dagc(NODE_TYPE type = NT_UNKNOWN, unsigned int index = 0, double value = 0, double multiplier = 1) :
+		dagc(NODE_TYPE type = NT_UNKNOWN, unsigned int index = 0, const rational value = 0, const rational multiplier = 1) :
 				t(type), id(index), v(value), m(multiplier) {};
 		~dagc() {};
 	
@@ -183,7 +270,7 @@ public:
 		const bool isneg() 		const { return !(m > 0); };
 	
 		const bool bval() 		const { return isneg() ? !(bool)v : (bool)v; };
-		const double nval() 	const { return v * m; };
+		const rational nval() 	const { return v * m; };
 
 		void negate(){ m = -m; };
 		void print() const { std::cout << t << ' ' << id << ' ' << v << ' ' << m << std::endl; };
@@ -202,6 +289,8 @@ public:
 		const bool is_true() const { return (!is_unknown() && v) ? true : false; };
 		const bool is_false() const { return (!is_unknown() && !v) ? true : false; };
 		const dagv operator!() const { return (is_unknown()) ? dagv() : dagv(!v); };
+		const bool operator==(const dagv &d) const { return v == d.v; };
+		const bool operator!=(const dagv &d) const { return v != d.v; };
 		void negate() { if (!is_unknown()) v = !v; };
 	private:
 		int v;
@@ -215,16 +304,12 @@ public:
 		var_vec() {};
 		~var_vec() {};
 		
-		//get & set value
-		dagv &val(const unsigned int index) { return vals[index]; };
-		dagv &operator()(const unsigned int index) { return vals[index]; };
-		
 		//get name 
 		const std::string name(const unsigned int index) const { return names[index]; };
 		const std::string operator[](const unsigned int index) const { return names[index]; };
 		
-		const unsigned int find(const std::string name) { 
-			boost::unordered_map<std::string, unsigned int>::iterator it = map.find(name);
+		const unsigned int find(const std::string name) const { 
+			boost::unordered_map<std::string, unsigned int>::const_iterator it = map.find(name);
 			return (it != map.end()) ? it->second : size(); };
 		
 		//push back element
@@ -240,10 +325,7 @@ public:
 		//size
 		const unsigned int size() const { return names.size(); };
 		
-		void init_vals() { vals.assign(size(), dagv()); };
-		
 	protected:
-		std::vector<dagv> vals;
 		std::vector<std::string> names;
 		boost::unordered_map<std::string, unsigned int>	map;
 	};
@@ -260,8 +342,8 @@ public:
 			
 		//push back element
 		unsigned int push_back(const ineqc ie) { 
-			std::pair<boost::unordered_map<std::vector<double>, unsigned int>::iterator, bool>
-				p = ineq_map.insert(std::pair<std::vector<double>, unsigned int>(ie.get_key(), size()));
+			std::pair<boost::unordered_map<std::vector<rational>, unsigned int>::iterator, bool>
+				p = ineq_map.insert(std::pair<std::vector<rational>, unsigned int>(ie.get_key(), size()));
 			if (p.second) {
 				//new inequalities
 				std::string name = mk_ineq_name(size());
@@ -273,7 +355,7 @@ public:
 
 	private:
 		std::vector<ineqc> ineqs;
-		boost::unordered_map<std::vector<double>, unsigned int> ineq_map;
+		boost::unordered_map<std::vector<rational>, unsigned int> ineq_map;
 		
 		std::string mk_ineq_name(unsigned int n) { char name[STRLEN]; sprintf(name, "_ie%d", n); return name; };
 	};
@@ -282,15 +364,12 @@ public:
 	// values, types and vectors of children
 	class op_vec {
 	public:
-		op_vec() {};
+		op_vec() : nineq(0) {};
 		~op_vec() {};
 		
-		//get & set value
-		dagv &operator()(const unsigned int index) { return vals[index]; };
-		dagv &val(const unsigned int index) { return vals[index]; };
-		
 		//get type	
 		NODE_TYPE &type(const unsigned int index) { return types[index]; };
+		const NODE_TYPE &type(const unsigned int index) const { return types[index]; };
 		
 		//get vector of children
 		std::vector<dagc> &children(const unsigned int index) { return ops[index]; };
@@ -301,34 +380,80 @@ public:
 			types.push_back(t); ops.push_back(elem); };
 		
 		//resize
-		void resize(unsigned int n) { vals.resize(n); types.resize(n); ops.resize(n); };
+		void resize(unsigned int n) { types.resize(n); ops.resize(n); };
 		
 		//size
 		const unsigned int size() const { return ops.size(); };
 		
-		void init_vals() { vals.assign(size(), dagv()); };
+		//flat index for evaluation, built after the DAG is completed
+		//nodes are keyed by operators [0, n), inequalities [n, n + nineqs), 
+		//and boolean variables [n + nineqs, n + nineqs + nvbools)
+		void build_index(const unsigned int nineqs, const unsigned int nvbools);
+		
+		const unsigned int key(const dagc node) const {
+			if (node.isboolop()) return node.id;
+			else if (node.isineq()) return size() + node.id;
+			else { assert(node.isvbool()); return size() + nineq + node.id; } };
+		const unsigned int ineq_key(const unsigned int index) const { return size() + index; };
+		const unsigned int vbool_key(const unsigned int index) const { return size() + nineq + index; };
+		const unsigned int nkeys() const { return fanout_off.size() - 1; };
+		
+		//flat children of an operator
+		const dagc *child_begin(const unsigned int index) const { return flat_child.data() + child_off[index]; };
+		const unsigned int nchildren(const unsigned int index) const { 
+			return child_off[index + 1] - child_off[index]; };
+		
+		//operators using a node as child
+		const unsigned int *fanout_begin(const unsigned int k) const { return flat_fanout.data() + fanout_off[k]; };
+		const unsigned int *fanout_end(const unsigned int k) const { return flat_fanout.data() + fanout_off[k + 1]; };
 		
 	private:
-		std::vector<dagv> vals;
 		std::vector<NODE_TYPE> types;
 		std::vector<std::vector<dagc>> ops;
+		
+		unsigned int				nineq;
+		std::vector<unsigned int>	child_off;
+		std::vector<dagc>			flat_child;
+		std::vector<unsigned int>	fanout_off;
+		std::vector<unsigned int>	flat_fanout;
 	};
 	
-	// element of a bunch
-	class bunch_elem {
+	// state of a bunch enumerator, values of literals are kept here instead of the lists
+	// parallel enumerators own private z3 contexts, z3 objects cannot be shared by threads
+	class enum_state {
 	public:
-		std::vector<dagv> ineq_vals;
-		std::vector<dagv> vbool_vals;
-	
-		bunch_elem(ineq_vec ineq_list, var_vec vbool_list) {
-			for (unsigned int i = 0; i < ineq_list.size(); i++)
-				ineq_vals.push_back(ineq_list(i));
-			for (unsigned int i = 0; i < vbool_list.size(); i++)
-				vbool_vals.push_back(vbool_list(i));
-		};
-		~bunch_elem() {};
-
-	private:
+		std::unique_ptr<z3::context>	own_ctx;	// NULL for the solver's own enumerator
+		z3::context						*ctx;
+		std::vector<z3::solver>			z3solvers;	// one for each component
+		std::vector<z3::solver>			skel;		// negated boolean skeletons of components, for prime bunches
+		std::vector<z3::expr>			ineq_lit;	// literals in ctx
+		std::vector<z3::expr>			vbool_lit;
+		unsigned int					comp;		// component under enumeration
+		std::vector<unsigned int>		fixed;		// literals of the cube, never reduced
+		unsigned int					cube;		// index of the cube, the component without cubes
+		unsigned int					last;		// index of the last bunch found in bunch_list
+		
+		//values under the current (partial) assignment
+		std::vector<dagv>				ineq_val;
+		std::vector<dagv>				vbool_val;
+		std::vector<dagv>				op_val;
+		
+		//incremental evaluation
+		std::vector<bool>			assert_sat;		// assert is true
+		unsigned int				eval_unsat;		// number of asserts of the component not true
+		std::vector<unsigned int>	eval_heap;		// min-heap of operators to evaluate
+		std::vector<bool>			eval_queued;
+		
+		//bunches of the current component (or cube) and their index for bunch strategy
+		bunch_store								bunches;
+		std::vector<std::vector<unsigned int>>	bunch_post;		// bunches with literal, at 2 * pos + val
+		std::vector<unsigned int>				bunch_conflicts;// decided literals differing from the current one
+		bsol									flip_cur;		// the current (partial) assignment
+		
+		enum_state() : ctx(NULL), comp(0), cube(0), last(0), eval_unsat(0), flip_cur(0) {};
+		enum_state(const enum_state &) = delete;
+		enum_state &operator=(const enum_state &) = delete;
+		~enum_state() {};
 	};
 	
 
@@ -354,17 +479,19 @@ public:
 	std::vector<z3::expr> 	vnum_expr;
 	std::vector<z3::expr> 	ineq_expr;
 	z3::context 			z3context;
-	z3::solver 				z3solver;
 	
 	//bunch pool
-	std::vector<bunch_elem> bunch_list;
+	bunch_store bunch_list;	// ineqs first, then boolean variables
 	
 	//volume & latte routine
 	//basic parameters
 	bool		enable_bunch;
+	bool		enable_prime;	// reduce bunches to prime implicants of the boolean skeleton
 	bool 		enable_fact;
+	bool		enable_comp;
 	bool		enable_ge;
 	int 		wordlength;
+	unsigned long seed;		// seed of random walks, 0 = by time
 	
 	std::string resultdir;	// dir of temp results
 	std::string tooldir;	// dir of tools, e.g., vinci, latte
@@ -375,15 +502,18 @@ public:
 	unsigned int stats_total_dims;
 	unsigned int stats_max_dims;
 	unsigned int stats_fact_bunches;
+	unsigned int stats_ge_vars;
 
 	
 //methods
 	solver(const std::string result_dir, const std::string tool_dir) : 
-				z3solver(z3context), 
 				enable_bunch(true),
+				enable_prime(false),
 				enable_fact(true),
+				enable_comp(true),
 				enable_ge(true),
 				wordlength(0),
+				seed(0),
 				resultdir(result_dir),
 				tooldir(tool_dir), 
 				stats_vol_calls(0),
@@ -391,6 +521,7 @@ public:
 				stats_total_dims(0),
 				stats_max_dims(0),
 				stats_fact_bunches(0),
+				stats_ge_vars(0),
 				logic(UNKNOWN_LOGIC),
 				solving_initialized(false) {};
 	solver(const std::string result_dir, const std::string tool_dir, std::string filename) : 
@@ -412,8 +543,8 @@ public:
 	const dagc		mk_false() const { 
 						if (solving_initialized) err_solving_initialized();
 						return dagc(NT_CONST_BOOL, 0, false); };
-	const dagc		mk_const(const std::string &s) const { return mk_const(stod(s)); };
-	const dagc		mk_const(const double v) const { return dagc(NT_CONST_NUM, 0, v); };
+	const dagc		mk_const(const std::string &s) const { return mk_const(rational(s)); };
+	const dagc		mk_const(const rational v) const { return dagc(NT_CONST_NUM, 0, v); };
 	const dagc		mk_bool_decl(const std::string &name);
 	const dagc		mk_var_decl(const std::string &name);
 	const dagc		mk_key_bind(const std::string &key, const dagc expr);
@@ -467,30 +598,75 @@ public:
 	const bool		solve();
 	
 	//volume & latte routine
-	const double 	call_latte() { 
-						return latte(bsols.back()) * multiplier.back(); };
-	const double 	call_latte(const unsigned int index) { 
-						return latte(bsols[index]) * multiplier[index]; };
-	const double 	call_barvinok() { 
-						return barvinok(bsols.back()) * multiplier.back(); };
-	const double 	call_barvinok(const unsigned int index) { 
-						return barvinok(bsols[index]) * multiplier[index]; };
-	const double 	call_alc() { 
-						return alc(bsols.back()) * multiplier.back(); };
-	const double 	call_alc(const unsigned int index) { 
-						return alc(bsols[index]) * multiplier[index]; };
-	const double 	call_vinci() { 
-						return vinci(bsols.back()) * multiplier.back(); };
-	const double 	call_vinci(const unsigned int index) {
-						return vinci(bsols[index]) * multiplier[index]; };
-	const double 	call_polyvest(const double epsilon, const double delta, const double coef) {
-						return polyvest(bsols.back(), epsilon, delta, coef) * multiplier.back(); };
-	const double 	call_polyvest(const unsigned int index, const double epsilon, const double delta, const double coef) {
-						return polyvest(bsols[index], epsilon, delta, coef) * multiplier[index]; };
+	//calls without scratch use the solver's own one, 
+	//calls with scratch can be made in parallel, one scratch for each worker
+	const rational 	call_latte() { 
+						return call_latte(bunch_list.size() - 1, scratch); };
+	const rational 	call_latte(const unsigned int index) { 
+						return call_latte(index, scratch); };
+	const rational 	call_latte(const unsigned int index, vol_scratch &sc) { 
+						bsol b; unsigned int m, nv; get_bunch(index, b, m, nv);
+						rational res = latte(b, nv, sc) * rational::pow2(m);
+						merge_stats(sc); return res; };
+	const rational 	call_barvinok() { 
+						return call_barvinok(bunch_list.size() - 1, scratch); };
+	const rational 	call_barvinok(const unsigned int index) { 
+						return call_barvinok(index, scratch); };
+	const rational 	call_barvinok(const unsigned int index, vol_scratch &sc) { 
+						bsol b; unsigned int m, nv; get_bunch(index, b, m, nv);
+						rational res = barvinok(b, nv, sc) * rational::pow2(m);
+						merge_stats(sc); return res; };
+	const bigvol 	call_alc() { 
+						return call_alc(bunch_list.size() - 1, scratch); };
+	const bigvol 	call_alc(const unsigned int index) { 
+						return call_alc(index, scratch); };
+	const bigvol 	call_alc(const unsigned int index, vol_scratch &sc) { 
+						bsol b; unsigned int m, nv; get_bunch(index, b, m, nv);
+						bigvol res = alc(b, nv, sc) * bigvol::pow2(m);
+						merge_stats(sc); return res; };
+	const bigvol 	call_vinci() { 
+						return call_vinci(bunch_list.size() - 1, scratch); };
+	const bigvol 	call_vinci(const unsigned int index) {
+						return call_vinci(index, scratch); };
+	const bigvol 	call_vinci(const unsigned int index, vol_scratch &sc) {
+						bsol b; unsigned int m, nv; get_bunch(index, b, m, nv);
+						bigvol res = vinci(b, nv, sc) * bigvol::pow2(m);
+						merge_stats(sc); return res; };
+	const bigvol 	call_polyvest(const double epsilon, const double delta, const double coef) {
+						return call_polyvest(bunch_list.size() - 1, epsilon, delta, coef, scratch); };
+	const bigvol 	call_polyvest(const unsigned int index, const double epsilon, const double delta, const double coef) {
+						return call_polyvest(index, epsilon, delta, coef, scratch); };
+	const bigvol 	call_polyvest(const unsigned int index, const double epsilon, const double delta, const double coef,
+								vol_scratch &sc) {
+						bsol b; unsigned int m, nv; get_bunch(index, b, m, nv);
+						// increase coef for the product of the components, as for factorization
+						bigvol res = polyvest(b, nv, epsilon, delta, coef * nComps, sc) * bigvol::pow2(m);
+						merge_stats(sc); return res; };
 	const VOL_RES_CLS 	call_v2l() { 
-							return v2l(bsols.back()) * multiplier.back(); };
+							return call_v2l(bunch_list.size() - 1, scratch); };
 	const VOL_RES_CLS 	call_v2l(const unsigned int index) {
-							return v2l(bsols[index]) * multiplier[index]; };
+							return call_v2l(index, scratch); };
+	const VOL_RES_CLS 	call_v2l(const unsigned int index, vol_scratch &sc) {
+							bsol b; unsigned int m, nv; get_bunch(index, b, m, nv);
+							VOL_RES_CLS res = v2l(b, nv, sc) * bigvol::pow2(m);
+							merge_stats(sc); return res; };
+	
+	//enumerate bunches on disjoint cubes of components by n threads, 
+	//found is called with the index of each new bunch, from any of the threads, 
+	//the enumeration stops once it returns false
+	void			solve(const unsigned int nthreads, const std::function<bool(unsigned int)> &found);
+	
+	//independent components, the total is the product of the sums of their bunches
+	const unsigned int	ncomps() const { return nComps; };
+	const unsigned int	get_comp(const unsigned int index) { 
+							std::lock_guard<std::mutex> lock(bunch_mutex); return comp_bunch[index]; };
+	
+	//indices of the bunches by their cubes, then by their order in the cube, 
+	//which does not depend on the threads that found them
+	void			bunch_order(std::vector<unsigned int> &order);
+	
+	//persistent cache of results in dir, one file for each engine
+	void			cache_open(const std::string dir);
 	
 	//print
 	void 			print_ast(const dagc root);
@@ -521,32 +697,65 @@ private:
 	//data structure
 	unsigned int 	nVars;		// = vnum_list.size()
 	unsigned int	nFormulas;	// = ineq_list.size()
-	arma::mat		bigA;		// mat A for all inequalities
+	std::vector<unsigned int> row_off;	// sparse A for all inequalities, row i in
+	std::vector<unsigned int> row_var;	// row_off[i] .. row_off[i + 1] - 1
+	std::vector<double> 	row_val;	// approximation of row_rat
+	std::vector<rational>	row_rat;	// exact values
+	std::vector<unsigned int> var_off;	// rows of each variable, var v in 
+	std::vector<unsigned int> var_row;	// var_off[v] .. var_off[v + 1] - 1
 	arma::vec		bigb;		// col B for all inequalities
+	std::vector<rational>	bigb_rat;	// exact col B
+	rational		bound_hi;	// wordlength bounds, 2^(w - 1) - 1
+	rational		bound_lo;	// -2^(w - 1)
+	std::vector<unsigned int> row_cls;	// class of identical or opposite rows (with b),
+	std::vector<int>		row_sgn;	// inequalities then 2 bounds of each var, 
+	unsigned int	nClasses;	// sign in the class, 0 for 0 = 0 rows
 	int 			*bigop;
-	arma::mat		matA;		// submat A for volume routines
-	arma::vec		colb;		// subcol B for volume routines
-	int				*rowop;
-	std::vector<long> 	multiplier;	//multiplier of bool sol
-	std::vector<int*> 	bsols;		//bunches (assignments)
+	vol_scratch		scratch;	// scratch for calls without a worker
+	std::vector<unsigned int> 	multiplier;	//multiplier of bool sol, as the exponent of 2
 	
-	//map for vol reusing
-	std::map<std::vector<int>, double> vol_map;
+	//independent components of the formula, enumerated one after another
+	unsigned int				nComps;
+	std::vector<unsigned int>	comp_lit;		// component of each literal, ineqs first
+	std::vector<unsigned int>	comp_vnum;		// component of each numeric variable
+	std::vector<unsigned int>	comp_assert;	// component of each assert
+	std::vector<unsigned int>	comp_nvars;		// number of numeric variables in each component
+	std::vector<unsigned int>	comp_bunch;		// component of each bunch
+	std::vector<std::pair<unsigned int, unsigned int>> rank_bunch;	// cube of each bunch and its index there
+	
+	//map for vol reusing, one for each engine, keyed by the canonical form of systems
+	std::unordered_map<key128, double, key128_hash> vol_map[ENG_NUM];
+	std::unordered_map<key128, rational, key128_hash> count_map[ENG_NUM];	// exact, for LattE & Barvinok
+	
+	//persistent cache across runs, one for each engine
+	vol_cache		disk_cache[ENG_NUM];
+	
+	//the solver's own enumerator, for solve() without threads
+	enum_state		enumr;
+	
+	//incremental evaluation, asserts on each node in the keys of bop_list
+	std::vector<unsigned int>	assert_off;
+	std::vector<unsigned int>	flat_assert;
+	
+	//locks for the state shared by workers and the enumeration
+	std::mutex		bunch_mutex;	// bunch_list, multiplier, comp_bunch, rank_bunch
+	std::mutex		vol_map_mutex;	// vol_map
+	std::mutex		stats_mutex;	// stats_*
 	
 //methods
 
 	//mk
 	const dagc		mk_err(const ERROR_TYPE t) const {return dagc(NT_ERROR, t); };
-	const dagc		mk_oper(const NODE_TYPE t, std::vector<dagc> &p, double val = 0, double mult = 1) {
+	const dagc		mk_oper(const NODE_TYPE t, std::vector<dagc> &p, const rational val = 0, const rational mult = 1) {
 						bop_list.push_back(t, p); return dagc(t, bop_list.size() - 1, val, mult); };
-	const dagc		mk_num_oper(const NODE_TYPE t, std::vector<dagc> &p, double val = 0, double mult = 1) {
+	const dagc		mk_num_oper(const NODE_TYPE t, std::vector<dagc> &p, const rational val = 0, const rational mult = 1) {
 						nop_list.push_back(t, p); return dagc(t, nop_list.size() - 1, val, mult); };
 
 	const dagc		mk_eq_bool(const dagc l, const dagc r);
 	// now we transform "l = r" into "(l <= r) and (l >= r)"
 	//const dagc	mk_eq_num(const dagc l, const dagc r) { return mk_ineq(true, l, r); };
 	
-	const dagc		mk_mul(const dagc p, const double m);
+	const dagc		mk_mul(const dagc p, const rational m);
 	
 	const dagc		mk_ineq(const bool iseq, const dagc l, const dagc r);
 	const dagc		mk_ineq_core(const bool iseq, const dagc lhs, const dagc rhs);
@@ -598,54 +807,92 @@ private:
 	void 			err_zero_divisor(const unsigned int ln) const;
 	
 	void			err_open_file(const std::string) const;
+	void			err_make_dir(const std::string) const;
 	void			err_solving_initialized() const;
 	void 			err_unbounded_polytope() const;
+	void			err_vinci_planes(const unsigned int nplanes) const;
+	void			err_tool_failed(const std::string tool) const;
 	void 			err_logic_latte() const;
 	void			err_logic_vinci() const;
 	void 			err_logic_polyvest() const;
 	
 	void 			warn_cmd_nsup(const std::string nm, const unsigned int ln) const;
+	void			warn_open_cache(const std::string filename) const;
 
 	//SMT solving
 	z3::expr		z3_mk_ineq(const unsigned int index);
 	z3::expr		z3_mk_term(const term t);
-	z3::expr		z3_mk_nconst(const double val);
+	z3::expr		z3_mk_nconst(const rational &val);
 	z3::expr		z3_mk_op(const unsigned int index);
 	z3::expr		z3_mk_expr(const dagc node);
-	
-	const bool 		get_result();
-	const dagv		eval_op(const unsigned int index);
-	const dagv		get_val(const dagc node);
+	void			decompose();
+	
+	// enumeration of the bunches of es.comp, within the cube of es
+	void			enum_init(enum_state &es, z3::context &c);
+	void			enum_reset(enum_state &es);
+	const bool		next_bunch(enum_state &es);
+	void			select_cube(const unsigned int comp, const unsigned int nbits, std::vector<unsigned int> &lits);
+	
+	const bool 		get_result(const enum_state &es) const { return es.eval_unsat == 0; };
+	const dagv		eval_op(const enum_state &es, const unsigned int index) const;
+	const dagv		get_val(const enum_state &es, const dagc node) const;
+	
+	// incremental evaluation for bunch strategy
+	// only the operators above a changed variable are evaluated again
+	void			eval_init(enum_state &es);
+	void			eval_assign(enum_state &es, const unsigned int key, dagv &var, const dagv val);
+	void			set_ineq(enum_state &es, const unsigned int index, const dagv val) { 
+						eval_assign(es, bop_list.ineq_key(index), es.ineq_val[index], val); };
+	void			set_vbool(enum_state &es, const unsigned int index, const dagv val) { 
+						eval_assign(es, bop_list.vbool_key(index), es.vbool_val[index], val); };
 	
 	// method for bunch strategy
-	// input: ineq_list and vbool_list
+	// input: values of ineqs and vbools in es
 	// output: ineqs and vbools which should be flipped
-	void			get_flip_list(std::vector<bool> &ineq_flip, std::vector<bool> &vbool_flip);
+	void			get_flip_list(enum_state &es, std::vector<bool> &ineq_flip, std::vector<bool> &vbool_flip);
+	// update the flip list after the literal at pos is reduced
+	void			update_flip_list(enum_state &es, const unsigned int pos, const dagv old, 
+								std::vector<bool> &ineq_flip, std::vector<bool> &vbool_flip);
+	void			mark_flip(enum_state &es, const unsigned int index, std::vector<bool> &ineq_flip, std::vector<bool> &vbool_flip);
+	void			index_bunch(enum_state &es, const unsigned int index);
+	
+	// prime implicants, decided literals are checked by z3 against the boolean skeleton
+	void			prime_bunch(enum_state &es, std::vector<bool> &ineq_flip, std::vector<bool> &vbool_flip);
+	const bool		skel_core(enum_state &es, const unsigned int skip, std::vector<bool> &in_core);
+	const bsol		cur_bunch(const enum_state &es) const;
 	
 	// volume & lattice routine
 	void				vol_init();
-	void 				mat_init(int *bools, unsigned int nRows, std::vector<int> vars);
-	unsigned int		gauss_elimination();
-	const unsigned int 	get_decided_vars(int *bools, std::vector<int> &vars);
-	const bool 			merge_sols(int *source, int *target);
-	const unsigned int 	factorize_bsol(int *bools, std::vector<int*> &pbools);
-	//const bool		bound_checking(int *bools, unsigned int nRows, std::vector<int> vars);
-	const double 		bound_computation();
-	const double 		polyvest_core(int *bools, unsigned int nRows, std::vector<int> vars, 
-								double epsilon, double delta, double coef);
-	const double 		polyvest(int *boolsol, double epsilon, double delta, double coef);
-	const double 		interval_vol();
-	const double 		vinci_core(int *bools, unsigned int nRows, std::vector<int> vars);
-	const double 		vinci(int *boolsol);
-	const double 		interval_count();
-	const double 		latte_core(int *bools, unsigned int nRows, std::vector<int> vars);
-	const double 		latte(int *boolsol);
-	const double 		barvinok_core(int *bools, unsigned int nRows, std::vector<int> vars);
-	const double 		barvinok(int *boolsol);
-	const double 		alc_core(int *bools, unsigned int nRows, std::vector<int> vars);
-	const double 		alc(int *boolsol);
-	const VOL_RES_CLS 	v2l_core(int *bools, unsigned int nRows, std::vector<int> vars);
-	const VOL_RES_CLS 	v2l(int *boolsol);
+	void 				mat_init(const bsol &bools, unsigned int nRows, std::vector<int> vars, vol_scratch &sc);
+	unsigned int		gauss_elimination(vol_scratch &sc, const bool lattice);
+	const unsigned int 	get_decided_vars(const bsol &bools, std::vector<int> &vars);
+	const unsigned int 	factorize_bsol(const bsol &bools, std::vector<bsol> &pbools);
+	static unsigned int	uf_find(std::vector<unsigned int> &parent, unsigned int v);
+	//const bool		bound_checking(const bsol &bools, unsigned int nRows, std::vector<int> vars);
+	const double 		bound_computation(vol_scratch &sc);
+	void				merge_stats(vol_scratch &sc);
+	const key128		canonical_key(const vol_scratch &sc);
+	const bool			vol_map_find(const VOL_ENGINE eng, vol_scratch &sc, double &val);
+	void				vol_map_insert(const VOL_ENGINE eng, vol_scratch &sc, const double val);
+	const bool			vol_map_find(const VOL_ENGINE eng, vol_scratch &sc, rational &val);
+	void				vol_map_insert(const VOL_ENGINE eng, vol_scratch &sc, const rational &val);
+	void				get_bunch(const unsigned int index, bsol &b, unsigned int &m, unsigned int &nv);
+	const double 		polyvest_core(const bsol &bools, unsigned int nRows, std::vector<int> vars, 
+								double epsilon, double delta, double coef, vol_scratch &sc);
+	const bigvol 		polyvest(const bsol &boolsol, const unsigned int nVars_comp, double epsilon, double delta, double coef, vol_scratch &sc);
+	const double 		interval_vol(vol_scratch &sc);
+	const double 		vinci_compute(const arma::mat &A, const arma::vec &b, const int *op);
+	const double 		vinci_core(const bsol &bools, unsigned int nRows, std::vector<int> vars, vol_scratch &sc);
+	const bigvol 		vinci(const bsol &boolsol, const unsigned int nVars_comp, vol_scratch &sc);
+	const rational 		interval_count(vol_scratch &sc);
+	const rational 		latte_core(const bsol &bools, unsigned int nRows, std::vector<int> vars, vol_scratch &sc);
+	const rational 		latte(const bsol &boolsol, const unsigned int nVars_comp, vol_scratch &sc);
+	const rational 		barvinok_core(const bsol &bools, unsigned int nRows, std::vector<int> vars, vol_scratch &sc);
+	const rational 		barvinok(const bsol &boolsol, const unsigned int nVars_comp, vol_scratch &sc);
+	const double 		alc_core(const bsol &bools, unsigned int nRows, std::vector<int> vars, vol_scratch &sc);
+	const bigvol 		alc(const bsol &boolsol, const unsigned int nVars_comp, vol_scratch &sc);
+	const VOL_RES_CLS 	v2l_core(const bsol &bools, unsigned int nRows, std::vector<int> vars, vol_scratch &sc);
+	const VOL_RES_CLS 	v2l(const bsol &boolsol, const unsigned int nVars_comp, vol_scratch &sc);
 	
 };
 
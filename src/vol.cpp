@@ -10,7 +10,14 @@
 
 #include "solver.h"
 #include "glpk.h"
+#include "vinci_lib.h"
 #include <limits>
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <cstdlib>
+#include <unistd.h>
+#include <dirent.h>
 
 bool check_all_zeros(arma::rowvec r) {
 	for (arma::rowvec::iterator it = r.begin(); it != r.end(); it++) {
@@ -19,122 +26,330 @@ bool check_all_zeros(arma::rowvec r) {
 	return true;
 }
 
+//////////////////////////////////////////////////////////////////////
+//// Temp directories ////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////
+
+//dirs alive, removed at exit in case a global error stops the program
+static std::mutex workdir_mutex;
+static std::set<std::string> workdir_set;
+
+//tmpfs if available, otherwise $TMPDIR or /tmp
+static const std::string workdir_root() {
+	if (access("/dev/shm", W_OK | X_OK) == 0) return "/dev/shm";
+	const char *tmp = getenv("TMPDIR");
+	if (tmp != NULL && tmp[0] != '\0') return tmp;
+	return "/tmp";
+}
+
+//the dir only holds plain files written by tools
+static void remove_dir(const std::string &dir) {
+	DIR *d = opendir(dir.c_str());
+	if (d != NULL) {
+		struct dirent *ent;
+		while ((ent = readdir(d)) != NULL) {
+			std::string name = ent->d_name;
+			if (name == "." || name == "..") continue;
+			unlink((dir + "/" + name).c_str());
+		}
+		closedir(d);
+	}
+	rmdir(dir.c_str());
+}
+
+static void remove_all_workdirs() {
+	std::lock_guard<std::mutex> lock(workdir_mutex);
+	for (std::set<std::string>::iterator it = workdir_set.begin(); it != workdir_set.end(); it++)
+		remove_dir(*it);
+	workdir_set.clear();
+}
+
+const bool volce::vol_scratch::make_workdir() {
+	std::string tmpl = workdir_root() + "/sharpSMT.XXXXXX";
+	std::vector<char> path(tmpl.begin(), tmpl.end());
+	path.push_back('\0');
+	if (mkdtemp(path.data()) == NULL) return false;
+	workdir = path.data();
+	
+	std::lock_guard<std::mutex> lock(workdir_mutex);
+	static bool registered = false;
+	if (!registered) {
+		atexit(remove_all_workdirs);
+		registered = true;
+	}
+	workdir_set.insert(workdir);
+	return true;
+}
+
+void volce::vol_scratch::remove_workdir() {
+	if (workdir.empty()) return;
+	std::lock_guard<std::mutex> lock(workdir_mutex);
+	remove_dir(workdir);
+	workdir_set.erase(workdir);
+	workdir.clear();
+}
+
 //////////////////////////////////////////////////////////////////////
 //// Initialization //////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////
+// a row (with b) multiplied by the sign of its first nonzero, as a key of var ids and values,
+// identical rows have the same key, so do opposite ones, returns the sign
+static int normalized_row(const unsigned int *var, const volce::rational *val, const unsigned int n, 
+	const volce::rational &b, std::vector<volce::rational> &key) {
+	
+	int sgn;
+	if (n > 0) sgn = (val[0] > 0) ? 1 : -1;
+	else sgn = (b > 0) ? 1 : ((b < 0) ? -1 : 0);
+	
+	key.clear();
+	for (unsigned int k = 0; k < n; k++) {
+		key.push_back((long)var[k]);
+		key.push_back((sgn < 0) ? -val[k] : val[k]);
+	}
+	key.push_back((sgn < 0) ? -b : b);
+	
+	return sgn;
+}
+
 void volce::solver::vol_init() {
 
 	nVars = vnum_list.size();
 	nFormulas = ineq_list.size();
 	
 	//linear constraints	
-	bigA.zeros(nFormulas, nVars);
 	bigb.zeros(nFormulas);
+	bigb_rat.resize(nFormulas);
 	bigop = new int[nFormulas];
+	row_off.assign(1, 0);
+	row_var.clear();
+	row_rat.clear();
 	
+	std::vector<int> pos(nVars, -1);	// position of a variable in the current row
 	for (unsigned int i = 0; i < nFormulas; i++) {		
 		//retrieve ineq
-		volce::ineqc ie = ineq_list[i];
+		volce::ineqc &ie = ineq_list[i];
 				
 		//op: eq 0, le -10, lt -1, gt 1, ge 10
 		if (ie.iseq()) bigop[i] = 0;
 		else bigop[i] = -10;
 		
-		//terms
+		//terms, the last one wins for repeated variables
+		unsigned int begin = row_var.size();
 		for (unsigned int j = 0; j < ie.size(); j++) {
-			bigA(i, ie[j].id) = ie[j].m;
+			if (pos[ie[j].id] < 0) {
+				pos[ie[j].id] = row_var.size();
+				row_var.push_back(ie[j].id);
+				row_rat.push_back(ie[j].m);
+			} else row_rat[pos[ie[j].id]] = ie[j].m;
+		}
+		bigb_rat[i] = ie.get_const_r();
+		bigb(i) = bigb_rat[i].get_d();
+		
+		//drop zeros, variables in increasing order
+		std::vector<std::pair<unsigned int, rational> > row;
+		for (unsigned int k = begin; k < row_var.size(); k++) {
+			pos[row_var[k]] = -1;
+			if (row_rat[k] != 0) row.push_back(std::make_pair(row_var[k], row_rat[k]));
 		}
-		bigb(i) = ie.get_const_r();
+		std::sort(row.begin(), row.end());
+		row_var.resize(begin);
+		row_rat.resize(begin);
+		for (unsigned int k = 0; k < row.size(); k++) {
+			row_var.push_back(row[k].first);
+			row_rat.push_back(row[k].second);
+		}
+		row_off.push_back(row_var.size());
 	}
+	
+	//approximations for the volume routines
+	row_val.resize(row_rat.size());
+	for (unsigned int k = 0; k < row_rat.size(); k++) row_val[k] = row_rat[k].get_d();
+	
+	//wordlength bounds, 2^(w - 1) - 1 and -2^(w - 1)
+	bound_lo = -1;
+	for (int w = 1; w < wordlength; w++) bound_lo *= 2;
+	bound_hi = -bound_lo - 1;
+	
+	//rows of each variable
+	var_off.assign(nVars + 1, 0);
+	for (unsigned int k = 0; k < row_var.size(); k++) var_off[row_var[k] + 1]++;
+	for (unsigned int v = 0; v < nVars; v++) var_off[v + 1] += var_off[v];
+	var_row.resize(row_var.size());
+	std::vector<unsigned int> next(var_off.begin(), var_off.end() - 1);
+	for (unsigned int i = 0; i < nFormulas; i++)
+		for (unsigned int k = row_off[i]; k < row_off[i + 1]; k++)
+			var_row[next[row_var[k]]++] = i;
+	
+	//classes of identical or opposite rows, including wordlength bounds
+	unsigned int nBounds = (wordlength > 0) ? 2 * nVars : 0;
+	row_cls.resize(nFormulas + nBounds);
+	row_sgn.resize(nFormulas + nBounds);
+	boost::unordered_map<std::vector<rational>, unsigned int> classes;
+	std::vector<rational> key;
+	rational one = 1;
+	for (unsigned int i = 0; i < nFormulas + nBounds; i++) {
+		if (i < nFormulas)
+			row_sgn[i] = normalized_row(&row_var[0] + row_off[i], &row_rat[0] + row_off[i], 
+				row_off[i + 1] - row_off[i], bigb_rat[i], key);
+		else {
+			// x <= 2^(w - 1) - 1, x >= -2^(w - 1)
+			unsigned int v = (i - nFormulas) / 2;
+			row_sgn[i] = normalized_row(&v, &one, 1, ((i - nFormulas) % 2 == 0) ? bound_hi : bound_lo, key);
+		}
+		row_cls[i] = classes.insert(std::make_pair(key, (unsigned int)classes.size())).first->second;
+	}
+	nClasses = classes.size();
 
 }
 
-void volce::solver::mat_init(int *bools, unsigned int nRows, std::vector<int> vars) {
+void volce::solver::mat_init(const bsol &bools, unsigned int nRows, std::vector<int> vars, vol_scratch &sc) {
 
 	unsigned int nVars = vars.size();
 	unsigned int counter = 0;
+	
+	//columns of variables, decided rows have no other variables
+	sc.colmap.resize(this->nVars);
+	for (unsigned int j = 0; j < nVars; j++) sc.colmap[vars[j]] = j;
+	if (sc.cls_head.size() != nClasses) sc.cls_head.assign(nClasses, -1);
 
 	if (wordlength > 0) {
 		nRows += 2 * nVars;
-		matA.set_size(nRows, nVars);
-		colb.set_size(nRows);
-		rowop = new int[nRows];
+		sc.matA.zeros(nRows, nVars);
+		sc.colb.set_size(nRows);
+		sc.rowop.resize(nRows);
+		sc.cls_next.resize(nRows);
+		sc.cls_row.resize(nRows);
+		if (sc.exact) {
+			sc.exA.assign(nRows * nVars, 0);
+			sc.exb.resize(nRows);
+		}
 		
 		// wordlength bounds
 		for (unsigned int i = 0; i < nVars; i++) {
-			for (unsigned int j = 0; j < nVars; j++) 
-				matA(counter, j) = 0;
-			matA(counter, i) = 1;
-			colb(counter) = pow(2, wordlength - 1) - 1;
-			rowop[counter] = -10;
+			sc.matA(counter, i) = 1;
+			sc.colb(counter) = pow(2, wordlength - 1) - 1;
+			sc.rowop[counter] = -10;
+			sc.cls_row[counter] = nFormulas + 2 * vars[i];
+			if (sc.exact) {
+				sc.exA[counter * nVars + i] = 1;
+				sc.exb[counter] = bound_hi;
+			}
 			counter++;
 			
-			for (unsigned int j = 0; j < nVars; j++) 
-				matA(counter, j) = 0;
-			matA(counter, i) = 1;
-			colb(counter) = -pow(2, wordlength - 1);
-			rowop[counter] = 10;
+			sc.matA(counter, i) = 1;
+			sc.colb(counter) = -pow(2, wordlength - 1);
+			sc.rowop[counter] = 10;
+			sc.cls_row[counter] = nFormulas + 2 * vars[i] + 1;
+			if (sc.exact) {
+				sc.exA[counter * nVars + i] = 1;
+				sc.exb[counter] = bound_lo;
+			}
 			counter++;
 		}
 		
 	} else {
-		matA.set_size(nRows, nVars);
-		colb.set_size(nRows);
-		rowop = new int[nRows];		
+		sc.matA.zeros(nRows, nVars);
+		sc.colb.set_size(nRows);
+		sc.rowop.resize(nRows);		
+		sc.cls_next.resize(nRows);
+		sc.cls_row.resize(nRows);
+		if (sc.exact) {
+			sc.exA.assign(nRows * nVars, 0);
+			sc.exb.resize(nRows);
+		}
 	}
 	
+	if (enable_ge)
+		for (unsigned int r = 0; r < counter; r++) {
+			unsigned int c = row_cls[sc.cls_row[r]];
+			sc.cls_next[r] = sc.cls_head[c];
+			sc.cls_head[c] = r;
+		}
+	
 	// inequalities
 	for(unsigned int i = 0; i < nFormulas; i++) {
 		if (bools[i] < 0) continue;
 			
 		if ((bigop[i] == 1 && bools[i] == 1) || (bigop[i] == -10 && bools[i] == 0)) {
 			// >
-			rowop[counter] = 1;
+			sc.rowop[counter] = 1;
 		} else if ((bigop[i] == 10 && bools[i] == 1) || (bigop[i] == -1 && bools[i] == 0)) {
 			// >=
-			rowop[counter] = 10;			
+			sc.rowop[counter] = 10;			
 		} else if ((bigop[i] == -1 && bools[i] == 1) || (bigop[i] == 10 && bools[i] == 0)) {
 			// <
-			rowop[counter] = -1;
+			sc.rowop[counter] = -1;
 		} else if ((bigop[i] == -10 && bools[i] == 1) || (bigop[i] == 1 && bools[i] == 0)) {
 			// <=
-			rowop[counter] = -10;
+			sc.rowop[counter] = -10;
 		} else 
 			assert(bigop[i] != 0);
 		
-		for (unsigned int j = 0; j < nVars; j++)
-			matA(counter, j) = bigA(i, vars[j]);
-		colb(counter) = bigb(i);
+		for (unsigned int k = row_off[i]; k < row_off[i + 1]; k++)
+			sc.matA(counter, sc.colmap[row_var[k]]) = row_val[k];
+		sc.colb(counter) = bigb(i);
+		sc.cls_row[counter] = i;
+		if (sc.exact) {
+			for (unsigned int k = row_off[i]; k < row_off[i + 1]; k++)
+				sc.exA[counter * nVars + sc.colmap[row_var[k]]] = row_rat[k];
+			sc.exb[counter] = bigb_rat[i];
+		}
 
 		bool redundent = false;
 		
 		if (enable_ge) {
-			for (unsigned int j = 0; j < counter; j++){
-				if (check_all_zeros(matA.row(counter) - matA.row(j)) && colb(counter) - colb(j) == 0) {
-					if (rowop[counter] == rowop[j]) {
+			//only the earlier rows of the same class are identical or opposite
+			unsigned int c = row_cls[i];
+			for (int j = sc.cls_head[c]; j >= 0; j = sc.cls_next[j]) {
+				int sgn = row_sgn[i] * row_sgn[sc.cls_row[j]];
+				if (sgn >= 0) {
+					// identical
+					if (sc.rowop[counter] == sc.rowop[j]) {
 						redundent = true;
-					} else if (rowop[counter] * rowop[j] == -100) {
+					} else if (sc.rowop[counter] * sc.rowop[j] == -100) {
 						// one is <=, another one is >=
 						redundent = true;
-						rowop[j] = 0;
+						sc.rowop[j] = 0;
 					}
 				}
-				if (check_all_zeros(matA.row(counter) + matA.row(j)) && colb(counter) + colb(j) == 0) {
-					if (rowop[counter] + rowop[j] == 0) {
+				if (sgn <= 0) {
+					// opposite
+					if (sc.rowop[counter] + sc.rowop[j] == 0) {
 						redundent = true;
-					} else if (rowop[counter] * rowop[j] == 100) {
+					} else if (sc.rowop[counter] * sc.rowop[j] == 100) {
 						redundent = true;
-						rowop[j] = 0;
+						sc.rowop[j] = 0;
 					}
 				}
 			}
+			if (!redundent) {
+				sc.cls_next[counter] = sc.cls_head[c];
+				sc.cls_head[c] = counter;
+			}
 		}
 		if (!redundent) counter++;
+		else {
+			//the row is reused by the next one
+			for (unsigned int k = row_off[i]; k < row_off[i + 1]; k++)
+				sc.matA(counter, sc.colmap[row_var[k]]) = 0;
+			if (sc.exact)
+				for (unsigned int k = row_off[i]; k < row_off[i + 1]; k++)
+					sc.exA[counter * nVars + sc.colmap[row_var[k]]] = 0;
+		}
 	}
 	
+	//clear the classes for the next call
+	if (enable_ge)
+		for (unsigned int r = 0; r < counter; r++)
+			sc.cls_head[row_cls[sc.cls_row[r]]] = -1;
+	
 	if (counter < nRows) {
-		matA.resize(counter, nVars);
-		colb.resize(counter);
+		sc.matA.resize(counter, nVars);
+		sc.colb.resize(counter);
+		if (sc.exact) {
+			sc.exA.resize(counter * nVars);
+			sc.exb.resize(counter);
+		}
 	}
 	
 }
@@ -143,49 +358,165 @@ void volce::solver::mat_init(int *bools, unsigned int nRows, std::vector<int> va
 //////////////////////////////////////////////////////////////////////
 //// Gauss Elimination ///////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////
-unsigned int volce::solver::gauss_elimination() {
+//substituting the variable of column col keeps the integer lattice only if 
+//the exact row divided by its coefficient is integral, e.g. a coefficient of 1 or -1
+static const bool lattice_pivot(const volce::vol_scratch &sc, const unsigned int row, const unsigned int col) {
+	unsigned int nCols = sc.matA.n_cols;
+	const volce::rational &p = sc.exA[row * nCols + col];
+	for (unsigned int j = 0; j < nCols; j++)
+		if (!(sc.exA[row * nCols + j] / p).is_integer()) return false;
+	return (sc.exb[row] / p).is_integer();
+}
+
+//lattice is set for the exact counting engines, LattE and Barvinok, 
+//an equation without a lattice pivot is kept as a pair of inequalities, 
+//the approximate engines need full-dimensional polytopes and take partial pivoting
+unsigned int volce::solver::gauss_elimination(vol_scratch &sc, const bool lattice) {
 
 	if (!enable_ge) return 0;
+	assert(!lattice || sc.exact);
 
 	unsigned int counter = 0;
+	unsigned int nRows = sc.matA.n_rows;
+	unsigned int nCols = sc.matA.n_cols;
+	
+	//rows and columns eliminated, removed at the end
+	std::vector<bool> row_out(nRows, false);
+	std::vector<bool> col_out(nCols, false);
+	std::vector<bool> row_kept(nRows, false);
+	unsigned int nCols_left = nCols;
 
-	for (unsigned int eqid = 0; eqid < matA.n_rows && matA.n_cols > 1; ) {
-		if (rowop[eqid] != 0){
-			eqid++;
+	for (unsigned int eqid = 0; eqid < nRows && nCols_left > 1; eqid++) {
+		if (sc.rowop[eqid] != 0) continue;
+		
+		// partial pivoting for volumes, the largest element, the first one for ties
+		// the first lattice pivot for counting
+		int nzid = -1;
+		bool nonzero = false;
+		for (unsigned int i = 0; i < nCols; i++) {
+			if (col_out[i] || !(sc.exact ? (bool)sc.exA[eqid * nCols + i] : sc.matA(eqid, i) != 0)) continue;
+			nonzero = true;
+			if (lattice) {
+				if (nzid < 0 && lattice_pivot(sc, eqid, i)) nzid = i;
+			} else if (nzid < 0 || std::fabs(sc.matA(eqid, i)) > std::fabs(sc.matA(eqid, nzid)))
+				nzid = i;
+		}
+		
+		if (nzid < 0 && nonzero) {
+			// kept as <= here, the >= copy is added at the end
+			sc.rowop[eqid] = -10;
+			row_kept[eqid] = true;
 			continue;
 		}
 		
-		// find first non-zero element
-		unsigned int nzid = 0;
-		for (unsigned int i = 0; i < matA.n_cols; i++)
-			if (matA(eqid, i) != 0) {
-				nzid = i;
-				break;
-			}
+		if (nzid < 0) {
+			// 0 = b, remove it if it holds, otherwise keep an unsatisfiable 0 <= b or 0 >= b
+			int sgn = sc.exact ? cmp(sc.exb[eqid], 0) : ((sc.colb(eqid) > 0) - (sc.colb(eqid) < 0));
+			if (sgn == 0) row_out[eqid] = true;
+			else sc.rowop[eqid] = (sgn < 0) ? -10 : 10;
+			continue;
+		}
 			
 		//std::cout << eqid << ' ' << nzid << std::endl;
 
-		for (unsigned int i = 0; i < matA.n_rows; i++) {
-			if (eqid != i) {
-				double coef = matA(i, nzid) / matA(eqid, nzid);
-				matA.row(i) -= coef * matA.row(eqid);
-				colb(i) -= coef * colb(eqid);
+		for (unsigned int i = 0; i < nRows; i++) {
+			if (eqid == i || row_out[i]) continue;
+			if (sc.exact) {
+				//exact elimination, doubles follow the exact values
+				rational *p = &sc.exA[eqid * nCols];
+				rational *r = &sc.exA[i * nCols];
+				if (!r[nzid]) continue;
+				rational coef = r[nzid] / p[nzid];
+				for (unsigned int j = 0; j < nCols; j++) {
+					if (col_out[j] || !p[j]) continue;
+					r[j] -= coef * p[j];
+					sc.matA(i, j) = r[j].get_d();
+				}
+				sc.exb[i] -= coef * sc.exb[eqid];
+				sc.colb(i) = sc.exb[i].get_d();
+				continue;
 			}
+			if (sc.matA(i, nzid) == 0) continue;
+			double coef = sc.matA(i, nzid) / sc.matA(eqid, nzid);
+			for (unsigned int j = 0; j < nCols; j++) {
+				if (col_out[j] || sc.matA(eqid, j) == 0) continue;
+				// cancellation leaves exact zeros
+				double d = coef * sc.matA(eqid, j);
+				double v = sc.matA(i, j) - d;
+				sc.matA(i, j) = (std::fabs(v) <= 1e-12 * std::fabs(d)) ? 0 : v;
+			}
+			sc.matA(i, nzid) = 0;
+			sc.colb(i) -= coef * sc.colb(eqid);
 		}
 		
-		matA.shed_row(eqid);
-		matA.shed_col(nzid);
-		colb.shed_row(eqid);
-		for (unsigned int i = eqid; i < matA.n_rows; i++){
-			rowop[i] = rowop[i + 1];
-		}
-		
+		row_out[eqid] = true;
+		col_out[nzid] = true;
+		nCols_left--;
 		counter++;
 	}
 
-	if (counter > 0) {
-		std::cout << "Gauss Elimination: " << counter << " variables." << std::endl;
+	//one compaction of the remaining rows and columns
+	unsigned int nRows_left = 0;
+	for (unsigned int i = 0; i < nRows; i++)
+		if (!row_out[i]) nRows_left++;
+	
+	std::vector<unsigned int> kept;
+	if (nRows_left < nRows || nCols_left < nCols) {
+		arma::mat A(nRows_left, nCols_left);
+		arma::vec b(nRows_left);
+		unsigned int r = 0;
+		for (unsigned int i = 0; i < nRows; i++) {
+			if (row_out[i]) continue;
+			unsigned int c = 0;
+			for (unsigned int j = 0; j < nCols; j++)
+				if (!col_out[j]) {
+					//rows only move up, in place for the exact copy
+					if (sc.exact) sc.exA[r * nCols_left + c] = sc.exA[i * nCols + j];
+					A(r, c++) = sc.matA(i, j);
+				}
+			if (sc.exact) sc.exb[r] = sc.exb[i];
+			b(r) = sc.colb(i);
+			sc.rowop[r] = sc.rowop[i];
+			if (row_kept[i]) kept.push_back(r);
+			r++;
+		}
+		sc.matA = A;
+		sc.colb = b;
+		if (sc.exact) {
+			sc.exA.resize(nRows_left * nCols_left);
+			sc.exb.resize(nRows_left);
+		}
+	} else {
+		for (unsigned int i = 0; i < nRows; i++)
+			if (row_kept[i]) kept.push_back(i);
+	}
+	
+	//the >= copies of the kept equations
+	if (!kept.empty()) {
+		unsigned int n = sc.matA.n_rows;
+		unsigned int m = n + kept.size();
+		sc.matA.resize(m, nCols_left);
+		sc.colb.resize(m);
+		if (sc.rowop.size() < m) sc.rowop.resize(m);
+		if (sc.exact) {
+			sc.exA.resize(m * nCols_left);
+			sc.exb.resize(m);
+		}
+		for (unsigned int k = 0; k < kept.size(); k++) {
+			unsigned int r = kept[k];
+			sc.matA.row(n + k) = sc.matA.row(r);
+			sc.colb(n + k) = sc.colb(r);
+			sc.rowop[n + k] = 10;
+			if (sc.exact) {
+				for (unsigned int j = 0; j < nCols_left; j++)
+					sc.exA[(n + k) * nCols_left + j] = sc.exA[r * nCols_left + j];
+				sc.exb[n + k] = sc.exb[r];
+			}
+		}
 	}
+
+	//counted instead of printed, workers run concurrently with the progress line
+	sc.stats_ge_vars += counter;
 	
 	return counter;
 
@@ -193,81 +524,258 @@ unsigned int volce::solver::gauss_elimination() {
 
 
 //////////////////////////////////////////////////////////////////////
-//// Factorization ///////////////////////////////////////////////////
+//// Canonical Form //////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////
-const unsigned int volce::solver::get_decided_vars(int *bools, std::vector<int> &vars){
 
-	for (unsigned int i = 0; i < nVars; i++) {
-		bool undecided = true;
-		for (unsigned int j = 0; j < nFormulas; j++) {
-			if (bools[j] < 0) continue;
-			if (bigA(j, i) != 0) {
-				undecided = false;
-				break;
+// x is an integer and exact in double
+static bool is_integral(const double x) {
+	return x == std::floor(x) && std::fabs(x) < 9007199254740992.0;
+}
+
+// equal signatures get equal ranks, smaller signatures get smaller ranks
+template <typename T>
+static void rank_sigs(const std::vector<T> &sigs, std::vector<unsigned int> &rank) {
+	std::vector<unsigned int> order(sigs.size());
+	for (unsigned int i = 0; i < order.size(); i++) order[i] = i;
+	std::sort(order.begin(), order.end(), 
+		[&sigs](unsigned int x, unsigned int y) { return sigs[x] < sigs[y]; });
+	rank.resize(sigs.size());
+	unsigned int r = 0;
+	for (unsigned int k = 0; k < order.size(); k++) {
+		if (k > 0 && sigs[order[k - 1]] < sigs[order[k]]) r++;
+		rank[order[k]] = r;
+	}
+}
+
+// values of the canonical form, exact ones by their digits
+static void hash_val(volce::hash128 &h, const double v) {
+	h.add(v);
+}
+
+static void hash_val(volce::hash128 &h, const volce::rational &v) {
+	h.add(v.str());
+}
+
+// key of the scaled rows a x op b, op is <, <= or =
+template <typename T>
+static const volce::key128 canonical_form(const unsigned int nRows, const unsigned int nCols, 
+	const std::vector<T> &A, const std::vector<T> &b, const std::vector<int> &op) {
+
+	//classes of variables and rows, refined by their nonzero entries
+	typedef std::vector<std::pair<T, unsigned int> > entries;
+	std::vector<unsigned int> rowcls, colcls;
+	{
+		std::vector<std::pair<int, T> > sigs(nRows);
+		for (unsigned int i = 0; i < nRows; i++) sigs[i] = std::make_pair(op[i], b[i]);
+		rank_sigs(sigs, rowcls);
+	}
+	for (unsigned int ncls = 0; ; ) {
+		std::vector<entries> colsigs(nCols);
+		for (unsigned int i = 0; i < nRows; i++)
+			for (unsigned int j = 0; j < nCols; j++)
+				if (A[i * nCols + j] != 0) 
+					colsigs[j].push_back(std::make_pair(A[i * nCols + j], rowcls[i]));
+		for (unsigned int j = 0; j < nCols; j++) 
+			std::sort(colsigs[j].begin(), colsigs[j].end());
+		rank_sigs(colsigs, colcls);
+		
+		std::vector<std::pair<unsigned int, entries> > rowsigs(nRows);
+		for (unsigned int i = 0; i < nRows; i++) {
+			rowsigs[i].first = rowcls[i];
+			for (unsigned int j = 0; j < nCols; j++)
+				if (A[i * nCols + j] != 0) 
+					rowsigs[i].second.push_back(std::make_pair(A[i * nCols + j], colcls[j]));
+			std::sort(rowsigs[i].second.begin(), rowsigs[i].second.end());
+		}
+		rank_sigs(rowsigs, rowcls);
+		
+		//stop once no class is split, the number of classes is the largest rank + 1
+		unsigned int n = 0, m = 0;
+		for (unsigned int j = 0; j < nCols; j++) n = std::max(n, colcls[j] + 1);
+		for (unsigned int i = 0; i < nRows; i++) m = std::max(m, rowcls[i] + 1);
+		if (n + m == ncls) break;
+		ncls = n + m;
+	}
+	
+	//variables ordered by class, ties keep their order
+	std::vector<unsigned int> perm(nCols);
+	for (unsigned int j = 0; j < nCols; j++) perm[j] = j;
+	std::stable_sort(perm.begin(), perm.end(), 
+		[&colcls](unsigned int x, unsigned int y) { return colcls[x] < colcls[y]; });
+	
+	//rows as (op, a, b) in the new order of variables, 
+	//the first nonzero coefficient of equations is positive
+	std::vector<std::vector<T> > rows(nRows);
+	for (unsigned int i = 0; i < nRows; i++) {
+		std::vector<T> &r = rows[i];
+		r.push_back(T(op[i]));
+		for (unsigned int j = 0; j < nCols; j++) 
+			r.push_back(A[i * nCols + perm[j]]);
+		r.push_back(b[i]);
+		if (op[i] == 0) {
+			unsigned int nz = 1;
+			while (nz <= nCols && r[nz] == 0) nz++;
+			if (nz <= nCols && r[nz] < 0)
+				for (unsigned int j = 1; j < r.size(); j++) r[j] = -r[j];
+		}
+	}
+	std::sort(rows.begin(), rows.end());
+	rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+	
+	volce::hash128 h;
+	h.add((uint64_t)nCols);
+	h.add((uint64_t)rows.size());
+	for (unsigned int i = 0; i < rows.size(); i++)
+		for (unsigned int j = 0; j < rows[i].size(); j++)
+			hash_val(h, rows[i][j]);
+	return h.get();
+
+}
+
+
+// key of the polytope {x | A x op b} in sc
+// systems get the same key if they differ only in the order of rows, 
+// positive scaling of rows, "> b" vs "< -b" rows, duplicate rows, and the order of
+// variables, as far as the refinement of rows and variables in canonical_form can tell them apart,
+// exact systems are keyed by their exact values
+const volce::key128 volce::solver::canonical_key(const vol_scratch &sc) {
+
+	unsigned int nRows = sc.matA.n_rows;
+	unsigned int nCols = sc.matA.n_cols;
+	std::vector<int> op(nRows);
+	for (unsigned int i = 0; i < nRows; i++)
+		op[i] = sc.rowop[i] > 0 ? -sc.rowop[i] : sc.rowop[i];
+	
+	//exact rows are scaled by the largest coefficient, exactly
+	if (sc.exact) {
+		std::vector<rational> A(nRows * nCols);
+		std::vector<rational> b(nRows);
+		for (unsigned int i = 0; i < nRows; i++) {
+			rational *a = &A[i * nCols];
+			rational scale = 0;
+			for (unsigned int j = 0; j < nCols; j++) {
+				a[j] = sc.rowop[i] > 0 ? -sc.exA[i * nCols + j] : sc.exA[i * nCols + j];
+				if (abs(a[j]) > scale) scale = abs(a[j]);
 			}
+			b[i] = sc.rowop[i] > 0 ? -sc.exb[i] : sc.exb[i];
+			if (!scale) continue;
+			for (unsigned int j = 0; j < nCols; j++) 
+				a[j] /= scale;
+			b[i] /= scale;
+		}
+		return canonical_form(nRows, nCols, A, b, op);
+	}
+	
+	//rows a x < b, a x <= b or a x = b, 
+	//scaled by the gcd of integer coefficients, otherwise by the largest coefficient
+	std::vector<double> A(nRows * nCols);
+	std::vector<double> b(nRows);
+	for (unsigned int i = 0; i < nRows; i++) {
+		double *a = &A[i * nCols];
+		double sign = sc.rowop[i] > 0 ? -1 : 1;
+		for (unsigned int j = 0; j < nCols; j++) 
+			a[j] = sign * sc.matA(i, j);
+		b[i] = sign * sc.colb(i);
+		
+		bool integral = true;
+		double scale = 0;
+		for (unsigned int j = 0; j < nCols; j++) {
+			if (!is_integral(a[j])) integral = false;
+			if (std::fabs(a[j]) > scale) scale = std::fabs(a[j]);
 		}
-		if (!undecided) {
-			vars.push_back(i);
+		if (integral) {
+			scale = 0;
+			for (unsigned int j = 0; j < nCols; j++)
+				for (double x = std::fabs(a[j]); x != 0; ) {
+					double t = std::fmod(scale, x);
+					scale = x;
+					x = t;
+				}
 		}
+		if (scale == 0) continue;
+		for (unsigned int j = 0; j < nCols; j++) 
+			a[j] /= scale;
+		b[i] /= scale;
 	}
 	
+	return canonical_form(nRows, nCols, A, b, op);
+
+}
+
+
+//////////////////////////////////////////////////////////////////////
+//// Factorization ///////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////
+// variables in the decided rows, in increasing order
+const unsigned int volce::solver::get_decided_vars(const bsol &bools, std::vector<int> &vars){
+
+	for (unsigned int v = 0; v < nVars; v++)
+		for (unsigned int k = var_off[v]; k < var_off[v + 1]; k++)
+			if (bools[var_row[k]] >= 0) {
+				vars.push_back(v);
+				break;
+			}
+	
 	assert(vars.size() <= nVars);
 	
 	return vars.size();
 }
 
-//merge target solution into source solution
-const bool volce::solver::merge_sols(int *source, int *target){
-
-	bool need_merge = false;
-	for (unsigned int i = 0; i < nFormulas; i++){
-		if (source[i] < 0) continue;
-		else if(source[i] == target[i]){
-			need_merge = true;
-			break;
-		}
+// root of the set of v, with path halving
+unsigned int volce::solver::uf_find(std::vector<unsigned int> &parent, unsigned int v) {
+	while (parent[v] != v) {
+		parent[v] = parent[parent[v]];
+		v = parent[v];
 	}
-	if (need_merge)
-		for (unsigned int i = 0; i < nFormulas; i++) 
-			source[i] = (target[i] == -1) ? source[i] : target[i];
-	
-	return need_merge;
+	return v;
 }
 
-const unsigned int volce::solver::factorize_bsol(int *bools, std::vector<int*> &pbools){
-	std::vector<int> constraints;
-	std::vector<int> vars;
-	unsigned int nc, nv;
+// decided rows sharing variables go to the same part, by union-find over variables
+// parts are ordered by their smallest variable
+const unsigned int volce::solver::factorize_bsol(const bsol &bools, std::vector<bsol> &pbools){
+
+	std::vector<unsigned int> parent(nVars);
+	std::vector<unsigned int> setsize(nVars, 1);
+	std::vector<bool> decided(nVars, false);
+	std::vector<int> first(nFormulas, -1);		// first variable of each decided row
+	for (unsigned int v = 0; v < nVars; v++) parent[v] = v;
+	
+	const uint64_t *known = bools.known();
+	for (unsigned int w = 0; w < bools.nwords(); w++)
+		for (uint64_t bits = known[w]; bits != 0; bits &= bits - 1) {
+			unsigned int i = 64 * w + __builtin_ctzll(bits);
+			for (unsigned int k = row_off[i]; k < row_off[i + 1]; k++) {
+				unsigned int v = row_var[k];
+				decided[v] = true;
+				if (first[i] < 0) {
+					first[i] = v;
+					continue;
+				}
+				//union by size
+				unsigned int r1 = uf_find(parent, first[i]);
+				unsigned int r2 = uf_find(parent, v);
+				if (r1 == r2) continue;
+				if (setsize[r1] < setsize[r2]) std::swap(r1, r2);
+				parent[r2] = r1;
+				setsize[r1] += setsize[r2];
+			}
+		}
 	
-	for (unsigned int i = 0; i < nFormulas; i++){
-		if (bools[i] < 0) continue;
-		constraints.push_back(i);
-	}
-	
-	nc = constraints.size();
-	nv = get_decided_vars(bools, vars);
-
-	for (unsigned int i = 0; i < nv; i++){
-		int *pbsol = new int[nFormulas];
-		for (unsigned int j = 0; j < nFormulas; j++) pbsol[j] = -1;
-		for (unsigned int j = 0; j < nc; j++)
-			if (bigA(constraints[j], vars[i]) != 0) 
-				pbsol[constraints[j]] = bools[constraints[j]];
-		pbools.push_back(pbsol);
-	}
-
-	for (unsigned int i = 0; i < pbools.size(); i++){
-		unsigned int j = i + 1;
-		while (j < pbools.size()){
-			if (merge_sols(pbools[i], pbools[j])){
-				delete[] pbools[j];
-				pbools.erase(pbools.begin() + j);
-				j = i + 1;
-			}else
-				j++;
+	//number the parts by their smallest variable
+	std::vector<int> part(nVars, -1);
+	for (unsigned int v = 0; v < nVars; v++) {
+		if (!decided[v]) continue;
+		unsigned int r = uf_find(parent, v);
+		if (part[r] < 0) {
+			part[r] = pbools.size();
+			pbools.push_back(bsol(nFormulas));
 		}
 	}
 	
+	for (unsigned int i = 0; i < nFormulas; i++)
+		if (first[i] >= 0)
+			pbools[part[uf_find(parent, first[i])]].set(i, bools[i]);
+	
 	return pbools.size();
 }
 
@@ -286,110 +794,73 @@ void WilsonCI(double p, double z, int n, double &up, double &lo){
 //bound checking for each call
 //employing linear programming
 //compute the error between the volume and the number of lattices
-const double volce::solver::bound_computation() {
+const double volce::solver::bound_computation(vol_scratch &sc) {
 
-	unsigned int nVars = matA.n_cols;
-	unsigned int nRows = matA.n_rows;
+	unsigned int nVars = sc.matA.n_cols;
+	unsigned int nRows = sc.matA.n_rows;
 	std::vector<double> max(nVars, 0);
 	std::vector<double> min(nVars, 0);
+	
+	//the box is kept in sc once all bounds are solved
+	sc.box_valid = false;
+	sc.box_max.resize(nVars);
+	sc.box_min.resize(nVars);
+	sc.box_center.zeros(nVars);
+	arma::vec point(nVars);
 
 	//init GLPK
-	glp_prob *lp;
-	lp = glp_create_prob();
-	glp_set_obj_dir(lp, GLP_MAX);
-	glp_add_rows(lp, nRows);
-	glp_add_cols(lp, nVars);
-
-	//disable msg output
-	glp_smcp parm;
-	glp_init_smcp(&parm);
-	parm.msg_lev = GLP_MSG_ERR;
+	polyvest::boxlp lp(sc.matA);
 
 	//load constraints
-	int *ind = new int[nVars + 1];
-	double *val = new double[nVars + 1];
-	
 	for(unsigned int i = 0; i < nRows; i++){
 		
-		//insert one row
-		for (unsigned int j = 0; j < nVars; j++) {
-			ind[j + 1] = j + 1;
-			val[j + 1] = matA(i, j);
-			//std::cout << matA(i, j) << ' ';
-		}
-		glp_set_mat_row(lp, i + 1, nVars, ind, val);
-		if (rowop[i] == 1) {
+		if (sc.rowop[i] == 1) {
 			// GT
-			glp_set_row_bnds(lp, i + 1, GLP_LO, colb(i) + 0.000001, 0);
-			//std::cout << "LO ";
-			//std::cout << colb(i) + 0.000001 << std::endl;
-		} else if (rowop[i] == 10) {
+			lp.SetRowBnds(i, GLP_LO, sc.colb(i) + 0.000001, 0);
+		} else if (sc.rowop[i] == 10) {
 			// GE
-			glp_set_row_bnds(lp, i + 1, GLP_LO, colb(i), 0);
-			//std::cout << "LO ";
-			//std::cout << colb(i) << std::endl;
-		} else if (rowop[i] == -1){
+			lp.SetRowBnds(i, GLP_LO, sc.colb(i), 0);
+		} else if (sc.rowop[i] == -1){
 			// LT
-			glp_set_row_bnds(lp, i + 1, GLP_UP, 0, colb(i) - 0.000001);
-			//std::cout << "UP ";
-			//std::cout << colb(i) - 0.000001 << std::endl;
-		} else if (rowop[i] == -10) {
+			lp.SetRowBnds(i, GLP_UP, 0, sc.colb(i) - 0.000001);
+		} else if (sc.rowop[i] == -10) {
 			// LE
-			glp_set_row_bnds(lp, i + 1, GLP_UP, 0, colb(i));
-			//std::cout << "UP ";
-			//std::cout << colb(i) << std::endl;
+			lp.SetRowBnds(i, GLP_UP, 0, sc.colb(i));
 		} else {
 			// EQ
-			glp_set_row_bnds(lp, i + 1, GLP_FX, 0, 0);
-			//std::cout << "FX ";
-			//std::cout << colb(i) << std::endl;
+			lp.SetRowBnds(i, GLP_FX, 0, 0);
 		}
 	}
-	delete []ind, delete []val;
-	for (unsigned int i = 1; i < nVars + 1; i++) {
-		glp_set_col_bnds(lp, i, GLP_FR, 0.0, 0.0);
-	}
 
 	// get a smallest lattice-cube contains the polytope
 	for (unsigned int i = 0; i < nVars; i++) {
 
-		//set obj and apply simplex method
-		for (unsigned int j = 1; j < nVars + 1; j++) 
-			glp_set_obj_coef(lp, j, 0);
-		glp_set_obj_coef(lp, i + 1, 1);
-		glp_simplex(lp, &parm);
-	
-		if (glp_get_status(lp) == GLP_UNBND) {
+		if (!lp.Solve(i, 1, sc.box_max[i], point.memptr())) {
 			//no upper bound, return negative number
 			std::cout << "UNBOUND\n";
-			glp_delete_prob(lp);
 			return -1;
 		} else {
-			max[i] = ceil(glp_get_obj_val(lp));
+			max[i] = ceil(sc.box_max[i]);
+			sc.box_center += point;
 		}
 
-		for (unsigned int j = 1; j < nVars + 1; j++) 
-			glp_set_obj_coef(lp, j, 0);
-		glp_set_obj_coef(lp, i + 1, -1);
-		glp_simplex(lp, &parm);
-	
-		if (glp_get_status(lp) == GLP_UNBND) {
+		if (!lp.Solve(i, -1, sc.box_min[i], point.memptr())) {
 			//no lower bound, return negative number
 			std::cout << "UNBOUND\n";
-			glp_delete_prob(lp);
 			return -1;
 		} else {
-			min[i] = floor(-glp_get_obj_val(lp));
+			min[i] = floor(sc.box_min[i]);
+			sc.box_center += point;
 		}
 		
 		// zero lattices
 		if (max[i] < min[i]) {
-			glp_delete_prob(lp);
 			return 0;
 		}
 	}
-
-	glp_delete_prob(lp);
+	
+	sc.box_center /= 2 * nVars;
+	sc.box_valid = true;
 	
 	double err = 0;
 	for (unsigned int i = 0; i < nVars; i++) {
@@ -412,19 +883,21 @@ const double volce::solver::bound_computation() {
 //////////////////////////////////////////////////////////////////////
 //// Volume Estimation ///////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////
-const double volce::solver::polyvest_core(int *bools, unsigned int nRows, std::vector<int> vars, 
-		double epsilon, double delta, double coef) {
+const double volce::solver::polyvest_core(const bsol &bools, unsigned int nRows, std::vector<int> vars, 
+		double epsilon, double delta, double coef, vol_scratch &sc) {
 		
 	//nVars: the number of "decided" numeric variables
 	//nRows: the number of "decided" linear formulas
 	//nFormulas: the number of linear formulas
 	//bools[nFormulas], vars[nVars]
-	mat_init(bools, nRows, vars);
-	unsigned int nelim = gauss_elimination();
-	if (matA.n_cols == 1)
-		return interval_vol();
-	double err = bound_computation();
-	if (nelim > 0) return 0;
+	//volumes run on doubles
+	sc.exact = false;
+	mat_init(bools, nRows, vars, sc);
+	//an equality makes the polytope lower-dimensional, even when one column is left
+	if (gauss_elimination(sc, false) > 0) return 0;
+	if (sc.matA.n_cols == 1)
+		return interval_vol(sc);
+	double err = bound_computation(sc);
 	
 	//bound checking
 	if (err < 0) {
@@ -432,27 +905,37 @@ const double volce::solver::polyvest_core(int *bools, unsigned int nRows, std::v
 	}
 	
 	//update stats of vol calls
-	stats_vol_calls++;
-	stats_total_dims += matA.n_cols;
-	if (matA.n_cols > stats_max_dims) stats_max_dims = matA.n_cols;
+	sc.stats_vol_calls++;
+	sc.stats_total_dims += sc.matA.n_cols;
+	if (sc.matA.n_cols > sc.stats_max_dims) sc.stats_max_dims = sc.matA.n_cols;
 
 	//estimating
-	polyvest::polytope p(matA.n_rows, matA.n_cols);
+	polyvest::polytope p(sc.matA.n_rows, sc.matA.n_cols);
 	
 	p.msg_off = true;
 	
-	for(unsigned int i = 0; i < matA.n_rows; i++){
+	//the same polytope gets the same walks with a given seed, whichever worker runs it
+	if (seed != 0) {
+		hash128 h;
+		key128 k = canonical_key(sc);
+		h.add((uint64_t)seed);
+		h.add(k.w[0]);
+		h.add(k.w[1]);
+		p.Seed(h.get().w[0]);
+	}
+	
+	for(unsigned int i = 0; i < sc.matA.n_rows; i++){
 
 		//insert one row		
-		if (rowop[i] > 0) {
-			p.b(i) = -colb(i);
-			for (unsigned int j = 0; j < matA.n_cols; j++)
-				p.A(i, j) = -matA(i, j);
-		} else if (rowop[i] < 0) {
-			p.b(i) = colb(i);
-			for (unsigned int j = 0; j < matA.n_cols; j++)
-				p.A(i, j) = matA(i, j);
-		} else assert(rowop[i] != 0);
+		if (sc.rowop[i] > 0) {
+			p.b(i) = -sc.colb(i);
+			for (unsigned int j = 0; j < sc.matA.n_cols; j++)
+				p.A(i, j) = -sc.matA(i, j);
+		} else if (sc.rowop[i] < 0) {
+			p.b(i) = sc.colb(i);
+			for (unsigned int j = 0; j < sc.matA.n_cols; j++)
+				p.A(i, j) = sc.matA(i, j);
+		} else assert(sc.rowop[i] != 0);
 /*	
 		for (unsigned int j = 0; j < i; j++){
 			if (check_all_zeros(p.A.row(i) + p.A.row(j)) &&
@@ -465,8 +948,12 @@ const double volce::solver::polyvest_core(int *bools, unsigned int nRows, std::v
 */
 	}
 
+	//the box solved by bound_computation
+	if (sc.box_valid)
+		p.SetBox(sc.box_max.data(), sc.box_min.data(), sc.box_center);
+
 	if (p.AffineTrans()){
-		p.EstimateVol(epsilon, delta, coef);
+		p.EstimateVol(epsilon, delta, coef, sc.chains);
 		return p.Volume();
 	}else{
 		//degenerate
@@ -475,7 +962,7 @@ const double volce::solver::polyvest_core(int *bools, unsigned int nRows, std::v
 	}
 }
 
-const double volce::solver::polyvest(int *boolsol, double epsilon, double delta, double coef){
+const volce::bigvol volce::solver::polyvest(const bsol &boolsol, const unsigned int nVars_comp, double epsilon, double delta, double coef, vol_scratch &sc){
 	std::vector<int> vars;
 	unsigned int nRows = 0;
 
@@ -484,16 +971,14 @@ const double volce::solver::polyvest(int *boolsol, double epsilon, double delta,
 		if (boolsol[i] >= 0)
 			nRows++;
 
-	if (nRows == 0) return 0;
-	
 	unsigned int nVars_decided_total = get_decided_vars(boolsol, vars);
 
 	// no factorization
 	if (!enable_fact){
-		unsigned int nVars_undecided = nVars - nVars_decided_total;
+		unsigned int nVars_undecided = nVars_comp - nVars_decided_total;
 		
 		//volume of cube consisted of undecided variables
-		double cube_vol = pow(pow(2, wordlength), nVars_undecided);
+		bigvol cube_vol = bigvol::pow2((long)wordlength * nVars_undecided);
 		if (wordlength == 0 && nVars_undecided > 0) {
 			//unbounded
 			err_unbounded_polytope();
@@ -502,60 +987,56 @@ const double volce::solver::polyvest(int *boolsol, double epsilon, double delta,
 		if (nVars_decided_total == 0)
 			return cube_vol;
 		else
-			return polyvest_core(boolsol, nRows, vars, epsilon, delta, coef) * cube_vol;
+			return bigvol(polyvest_core(boolsol, nRows, vars, epsilon, delta, coef, sc)) * cube_vol;
 	}
 	
-	double vol = 1;
+	bigvol vol = 1;
 	
 	//factorization
-	std::vector<int*> pbools;
+	std::vector<bsol> pbools;
 	unsigned int nVars_tmp = 0;
 	unsigned int npbools = factorize_bsol(boolsol, pbools);
 
 	//count the bunch factorized
-	if (npbools > 1) stats_fact_bunches++;
+	if (npbools > 1) sc.stats_fact_bunches++;
 	
 	//compute each subproblem
 	for (unsigned int i = 0; i < npbools; i++){
 		vars.clear();
-		nRows = 0;
-		for (unsigned int j = 0; j < nFormulas; j++){
-			if (pbools[i][j] < 0) continue;
-			nRows++;
-		}
+		nRows = pbools[i].count();
 	
 		unsigned int nVars_decided = get_decided_vars(pbools[i], vars);
 		nVars_tmp += nVars_decided;
 		
 		// increase coef while partitions into some pieces
-		vol *= polyvest_core(pbools[i], nRows, vars, epsilon, delta, coef * npbools);
+		vol *= bigvol(polyvest_core(pbools[i], nRows, vars, epsilon, delta, coef * npbools, sc));
 	}
 	
-	assert(nVars_decided_total <= nVars);
+	assert(nVars_decided_total <= nVars_comp);
 	assert(nVars_decided_total == nVars_tmp);
 	
-	if (wordlength == 0 && nVars - nVars_decided_total > 0) {
+	if (wordlength == 0 && nVars_comp - nVars_decided_total > 0) {
 		//unbounded
 		err_unbounded_polytope();
 	} 
 	
 	if (nVars_decided_total == 0) {
-		double v = pow(pow(2, wordlength), nVars);
+		bigvol v = bigvol::pow2((long)wordlength * nVars_comp);
 		return v;
 	} else
-		return vol * pow(pow(2, wordlength), nVars - nVars_decided_total);
+		return vol * bigvol::pow2((long)wordlength * (nVars_comp - nVars_decided_total));
 }
 
 
 //////////////////////////////////////////////////////////////////////
 //// Volume Computation //////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////
-const double volce::solver::interval_vol(){
+const double volce::solver::interval_vol(vol_scratch &sc){
 
 	//update stats of vol calls
-	stats_vol_calls++;
-	stats_total_dims++;
-	if (stats_max_dims < 1) stats_max_dims = 1;
+	sc.stats_vol_calls++;
+	sc.stats_total_dims++;
+	if (sc.stats_max_dims < 1) sc.stats_max_dims = 1;
 
 	double max, min;
 
@@ -567,11 +1048,11 @@ const double volce::solver::interval_vol(){
 		min = -pow(2, wordlength - 1);
 	}
 	
-	for (unsigned int i = 0; i < matA.n_rows; i++){
-		if (matA(i, 0) == 0) continue;
+	for (unsigned int i = 0; i < sc.matA.n_rows; i++){
+		if (sc.matA(i, 0) == 0) continue;
 		
-		double v = colb[i] / matA(i, 0);		
-		int cmp = matA(i, 0) < 0 ? -rowop[i] : rowop[i];
+		double v = sc.colb[i] / sc.matA(i, 0);		
+		int cmp = sc.matA(i, 0) < 0 ? -sc.rowop[i] : sc.rowop[i];
 
 		if (cmp > 0){
 			if (v > min) min = v;
@@ -593,17 +1074,134 @@ const double volce::solver::interval_vol(){
 	else return max - min;
 }
 
-const double volce::solver::vinci_core(int *bools, unsigned int nRows, std::vector<int> vars){
+// compute the volume of {x | A x op b} by the linked Vinci library
+// rows are passed to Vinci as a x <= b, ">" and ">=" rows are negated
+// Vinci handles at most 254 rows, larger systems raise a global error
+const double volce::solver::vinci_compute(const arma::mat &A, const arma::vec &b, const int *op) {
+
+	unsigned int nRows = A.n_rows;
+	unsigned int nCols = A.n_cols;
+	std::vector<double> planes(nRows * (nCols + 1));
+	
+	for (unsigned int i = 0; i < nRows; i++) {
+	
+		double *row = &planes[i * (nCols + 1)];
+		
+		if (op[i] > 0) {
+			for (unsigned int j = 0; j < nCols; j++)
+				row[j] = -A(i, j);
+			row[nCols] = -b(i);
+		} else if (op[i] < 0) {
+			for (unsigned int j = 0; j < nCols; j++)
+				row[j] = A(i, j);
+			row[nCols] = b(i);
+		} else assert(op[i] != 0);
+	}
+	
+	//vinci_volume serializes the calls of all threads itself
+	double vol = vinci_volume(nRows, nCols, planes.data());
+	if (vol < 0) err_vinci_planes(nRows);
+	return vol;
+
+}
+
+// results are searched in vol_map, then in the persistent cache
+// the key of the system in sc is computed here and kept in sc for vol_map_insert
+const bool volce::solver::vol_map_find(const VOL_ENGINE eng, vol_scratch &sc, double &val) {
+	sc.key = canonical_key(sc);
+	{
+		std::lock_guard<std::mutex> lock(vol_map_mutex);
+		std::unordered_map<key128, double, key128_hash>::iterator vol_map_iter = vol_map[eng].find(sc.key);
+		if (vol_map_iter != vol_map[eng].end()) {
+			val = vol_map_iter->second;
+			return true;
+		}
+	}
+	if (disk_cache[eng].find(sc.key, val)) {
+		std::lock_guard<std::mutex> lock(vol_map_mutex);
+		vol_map[eng].insert(std::make_pair(sc.key, val));
+		return true;
+	}
+	return false;
+}
+
+void volce::solver::vol_map_insert(const VOL_ENGINE eng, vol_scratch &sc, const double val) {
+	{
+		std::lock_guard<std::mutex> lock(vol_map_mutex);
+		vol_map[eng].insert(std::make_pair(sc.key, val));
+	}
+	disk_cache[eng].insert(sc.key, val);
+}
+
+// exact counts, never rounded to doubles
+const bool volce::solver::vol_map_find(const VOL_ENGINE eng, vol_scratch &sc, rational &val) {
+	sc.key = canonical_key(sc);
+	{
+		std::lock_guard<std::mutex> lock(vol_map_mutex);
+		std::unordered_map<key128, rational, key128_hash>::iterator count_map_iter = count_map[eng].find(sc.key);
+		if (count_map_iter != count_map[eng].end()) {
+			val = count_map_iter->second;
+			return true;
+		}
+	}
+	if (disk_cache[eng].find(sc.key, val)) {
+		std::lock_guard<std::mutex> lock(vol_map_mutex);
+		count_map[eng].insert(std::make_pair(sc.key, val));
+		return true;
+	}
+	return false;
+}
+
+void volce::solver::vol_map_insert(const VOL_ENGINE eng, vol_scratch &sc, const rational &val) {
+	{
+		std::lock_guard<std::mutex> lock(vol_map_mutex);
+		count_map[eng].insert(std::make_pair(sc.key, val));
+	}
+	disk_cache[eng].insert(sc.key, val);
+}
+
+// files of the persistent cache in dir
+void volce::solver::cache_open(const std::string dir) {
+	const std::string names[ENG_NUM] = {"latte", "barvinok", "alc", "vinci", "v2l"};
+	for (unsigned int eng = 0; eng < ENG_NUM; eng++) {
+		std::string filename = dir + "/" + names[eng] + ".cache";
+		if (!disk_cache[eng].open(filename)) warn_open_cache(filename);
+	}
+}
+
+// bunches may be appended by solve() while workers read them
+void volce::solver::get_bunch(const unsigned int index, bsol &b, unsigned int &m, unsigned int &nv) {
+	std::lock_guard<std::mutex> lock(bunch_mutex);
+	b = bunch_list.get(index, nFormulas);
+	m = multiplier[index];
+	nv = comp_nvars[comp_bunch[index]];
+}
+
+// add the stats of a worker to the solver stats
+void volce::solver::merge_stats(vol_scratch &sc) {
+	std::lock_guard<std::mutex> lock(stats_mutex);
+	stats_vol_calls += sc.stats_vol_calls;
+	stats_vol_reuses += sc.stats_vol_reuses;
+	stats_total_dims += sc.stats_total_dims;
+	if (sc.stats_max_dims > stats_max_dims) stats_max_dims = sc.stats_max_dims;
+	stats_fact_bunches += sc.stats_fact_bunches;
+	stats_ge_vars += sc.stats_ge_vars;
+	sc.reset_stats();
+}
+
+const double volce::solver::vinci_core(const bsol &bools, unsigned int nRows, std::vector<int> vars, vol_scratch &sc){
 	//nVars: the number of "decided" numeric variables
 	//nRows: the number of "decided" linear formulas
 	//nFormulas: the number of linear formulas
 	//bools[nFormulas], vars[nVars]
-	mat_init(bools, nRows, vars);
-	unsigned int nelim = gauss_elimination();
-	if (matA.n_cols == 1)
-		return interval_vol();
-	double err = bound_computation();
-	if (nelim > 0) return 0;
+	//volumes run on doubles
+	sc.exact = false;
+	mat_init(bools, nRows, vars, sc);
+	//an equality makes the polytope lower-dimensional, even when one column is left
+	if (gauss_elimination(sc, false) > 0) return 0;
+	if (sc.matA.n_cols == 1)
+		return interval_vol(sc);
+	double err = bound_computation(sc);
 	
 	//bound checking
 	if (err < 0) {
@@ -611,118 +1209,46 @@ const double volce::solver::vinci_core(int *bools, unsigned int nRows, std::vect
 	}
 	
 	//search previous computation result for reusing
-	std::vector<int> bools_vec;
-	if (enable_fact) {
-		for (unsigned int i = 0; i < nFormulas; i++) 
-			bools_vec.push_back(bools[i]);
-		std::map<std::vector<int>, double>::iterator vol_map_iter = vol_map.find(bools_vec);
-		if (vol_map_iter != vol_map.end()) {
-			//result exist
-			stats_vol_reuses++;
-			return vol_map_iter->second;
-		}
+	double reuse;
+	if (vol_map_find(ENG_VINCI, sc, reuse)) {
+		//result exist
+		sc.stats_vol_reuses++;
+		return reuse;
 	}
 	
 	//update stats of vol calls
-	stats_vol_calls++;
-	stats_total_dims += matA.n_cols;
-	if (matA.n_cols > stats_max_dims) stats_max_dims = matA.n_cols;
+	sc.stats_vol_calls++;
+	sc.stats_total_dims += sc.matA.n_cols;
+	if (sc.matA.n_cols > sc.stats_max_dims) sc.stats_max_dims = sc.matA.n_cols;
 	
 	// compute
-	std::string filename = tooldir + "/vinci_input_tmp"; //.ine
-
-	std::ofstream ofile;
-	
-	ofile.open(filename + ".ine");
-	if (!ofile.is_open()) {
-		err_open_file(filename);
-	}
-
-	//set printf format
-	ofile.setf(std::ios::fixed, std::ios::floatfield);
-
-	ofile << "H-representation" << std::endl;
-	ofile << "begin" << std::endl;
-	ofile << matA.n_rows << " " << matA.n_cols + 1 << " real" << std::endl;
-	
-	for(unsigned int i = 0; i < matA.n_rows; i++) {
-
-		if (rowop[i] > 0) {
-			ofile << -colb[i] << " ";
-			for (unsigned int j = 0; j < matA.n_cols; j++)
-				ofile << matA(i, j) << " ";
-			ofile << std::endl;
-		} else if (rowop[i] < 0) {
-			ofile << colb[i] << " ";
-			for (unsigned int j = 0; j < matA.n_cols; j++)
-				ofile << -matA(i, j) << " ";
-			ofile << std::endl;
-		} else {
-			assert(rowop[i] != 0);
-/*
-			ofile << -colb[i] << " ";
-			for (unsigned int j = 0; j < matA.n_cols; j++)
-				ofile << matA(i, j) << " ";
-			ofile << std::endl;
-			ofile << colb[i] << " ";
-			for (unsigned int j = 0; j < matA.n_cols; j++)
-				ofile << -matA(i, j) << " ";
-			ofile << std::endl;
-*/
-		}
-	}
+	double vol = vinci_compute(sc.matA, sc.colb, sc.rowop.data());
 	
-	ofile << "end" << std::endl;
-	
-	ofile.close();
-	
-	//execute vinci
-	std::string cmd = "cd " + tooldir + "; ./vinci vinci_input_tmp >/dev/null";
-	int proc = system(cmd.c_str());
-	
-	//read result
-	std::ifstream ifile;
-	double vol = 0;
-	filename = tooldir + "/vinci.result";
-
-	ifile.open(filename);
-	if (!ifile.is_open()) {
-		err_open_file(filename);
-	}
-	
-	ifile >> vol;
-	
-	ifile.close();	
-	
-	if (enable_fact) {
-		//new entry
-		vol_map.insert(std::pair<std::vector<int>, double>(bools_vec, vol));
-	}
+	//new entry
+	vol_map_insert(ENG_VINCI, sc, vol);
 	return vol;
 	
 }
 
-const double volce::solver::vinci(int *boolsol){
+const volce::bigvol volce::solver::vinci(const bsol &boolsol, const unsigned int nVars_comp, vol_scratch &sc){
 
 	std::vector<int> vars;
 	unsigned int nRows = 0;
-	double vol = 1;
+	bigvol vol = 1;
 	
 	// count rows
 	for (unsigned int i = 0; i < nFormulas; i++)
 		if (boolsol[i] >= 0) 
 			nRows++;
 
-	if (nRows == 0) return 0;
-	
 	unsigned int nVars_decided_total = get_decided_vars(boolsol, vars);
 	
 	// no factorization
 	if (!enable_fact){
-		unsigned int nVars_undecided = nVars - nVars_decided_total;
+		unsigned int nVars_undecided = nVars_comp - nVars_decided_total;
 		
 		//volume of cube consisted of undecided variables
-		double cube_vol = pow(pow(2, wordlength), nVars_undecided);
+		bigvol cube_vol = bigvol::pow2((long)wordlength * nVars_undecided);
 		if (wordlength == 0 && nVars_undecided > 0) {
 			//unbounded
 			err_unbounded_polytope();
@@ -731,56 +1257,85 @@ const double volce::solver::vinci(int *boolsol){
 		if (nVars_decided_total == 0)
 			return cube_vol;
 		else
-			return vinci_core(boolsol, nRows, vars) * cube_vol;
+			return bigvol(vinci_core(boolsol, nRows, vars, sc)) * cube_vol;
 	}
 	
 	//factorization
-	std::vector<int*> pbools;
+	std::vector<bsol> pbools;
 	unsigned int nVars_tmp = 0;
 	unsigned int npbools = factorize_bsol(boolsol, pbools);
 	
 	//count the bunch factorized
-	if (npbools > 1) stats_fact_bunches++;
+	if (npbools > 1) sc.stats_fact_bunches++;
 	
 	//compute each subproblem
 	for (unsigned int i = 0; i < npbools; i++){
 		vars.clear();
-		nRows = 0;
-		for (unsigned int j = 0; j < nFormulas; j++){
-			if (pbools[i][j] < 0) continue;
-			nRows++;
-		}
+		nRows = pbools[i].count();
 	
 		unsigned int nVars_decided = get_decided_vars(pbools[i], vars);
 		nVars_tmp += nVars_decided;
 		
-		vol *= vinci_core(pbools[i], nRows, vars);
+		vol *= bigvol(vinci_core(pbools[i], nRows, vars, sc));
 	}
 	
-	assert(nVars_decided_total <= nVars);
+	assert(nVars_decided_total <= nVars_comp);
 	assert(nVars_decided_total == nVars_tmp);
 	
-	if (wordlength == 0 && nVars - nVars_decided_total > 0) {
+	if (wordlength == 0 && nVars_comp - nVars_decided_total > 0) {
 		//unbounded
 		err_unbounded_polytope();
 	}
 	
 	if (nVars_decided_total == 0) {
-		double v = pow(pow(2, wordlength), nVars);
+		bigvol v = bigvol::pow2((long)wordlength * nVars_comp);
 		return v;
 	} else
-		return vol * pow(pow(2, wordlength), nVars - nVars_decided_total);
+		return vol * bigvol::pow2((long)wordlength * (nVars_comp - nVars_decided_total));
 }
 
 //////////////////////////////////////////////////////////////////////
 //// Lattice Counting ////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////
-const double volce::solver::interval_count(){
+const volce::rational volce::solver::interval_count(vol_scratch &sc){
 
 	//update stats of vol calls
-	stats_vol_calls++;
-	stats_total_dims++;
-	if (stats_max_dims < 1) stats_max_dims = 1;
+	sc.stats_vol_calls++;
+	sc.stats_total_dims++;
+	if (sc.stats_max_dims < 1) sc.stats_max_dims = 1;
+
+	if (sc.exact) {
+		//exact bounds of the variable
+		bool bounded = (wordlength > 0);
+		bool has_max = bounded, has_min = bounded;
+		rational max = bound_hi, min = bound_lo;
+		for (unsigned int i = 0; i < sc.matA.n_rows; i++) {
+			if (!sc.exA[i]) continue;
+			
+			rational v = sc.exb[i] / sc.exA[i];
+			int op = (sc.exA[i] < 0) ? -sc.rowop[i] : sc.rowop[i];
+			
+			if (op == 1 || op == 10 || op == 0) {
+				//GT, GE, EQ
+				rational lo = (op == 1) ? v.floor() + 1 : v.ceil();
+				if (!has_min || lo > min) min = lo;
+				has_min = true;
+			}
+			if (op == -1 || op == -10 || op == 0) {
+				//LT, LE, EQ
+				rational up = (op == -1) ? v.ceil() - 1 : v.floor();
+				if (!has_max || up < max) max = up;
+				has_max = true;
+			}
+		}
+		
+		if (!has_max || !has_min) {
+			err_unbounded_polytope();
+		}
+		
+		if (max < min) return 0;
+		else return max - min + 1;
+	}
 
 	double max, min;
 
@@ -791,15 +1346,15 @@ const double volce::solver::interval_count(){
 		max = pow(2, wordlength - 1) - 1;
 		min = -pow(2, wordlength - 1);
 	}
-	for (unsigned int i = 0; i < matA.n_rows; i++){
+	for (unsigned int i = 0; i < sc.matA.n_rows; i++){
 		
-		if (matA(i, 0) == 0) continue;
+		if (sc.matA(i, 0) == 0) continue;
 		
-		double v = colb[i] / matA(i, 0);
+		double v = sc.colb[i] / sc.matA(i, 0);
 		
-		int cmp = rowop[i];
+		int cmp = sc.rowop[i];
 		
-		if (matA(i, 0) < 0) cmp = -cmp;	
+		if (sc.matA(i, 0) < 0) cmp = -cmp;	
 		
 		if (cmp == 1){
 			//GT
@@ -836,19 +1391,37 @@ const double volce::solver::interval_count(){
 	}
 	
 	if ((max - min) < 0) return 0;
-	else return (max - min + 1);
+	else return rational(max - min + 1);
+}
+
+// row i of the exact copy scaled by a positive number to integers
+static void integer_row(const volce::vol_scratch &sc, const unsigned int i, 
+	std::vector<volce::rational> &a, volce::rational &b) {
+	
+	unsigned int nCols = sc.matA.n_cols;
+	volce::rational scale = 1;
+	for (unsigned int j = 0; j < nCols; j++)
+		scale *= (sc.exA[i * nCols + j] * scale).den();
+	scale *= (sc.exb[i] * scale).den();
+	
+	a.resize(nCols);
+	for (unsigned int j = 0; j < nCols; j++)
+		a[j] = sc.exA[i * nCols + j] * scale;
+	b = sc.exb[i] * scale;
 }
 
-const double volce::solver::latte_core(int *bools, unsigned int nRows, std::vector<int> vars){
+const volce::rational volce::solver::latte_core(const bsol &bools, unsigned int nRows, std::vector<int> vars, vol_scratch &sc){
 	//nVars: the number of "decided" numeric variables
 	//nRows: the number of "decided" linear formulas
 	//nFormulas: the number of linear formulas
 	//bools[nFormulas], vars[nVars]
-	mat_init(bools, nRows, vars);
-	gauss_elimination();
-	if (matA.n_cols == 1) 
-		return interval_count();
-	double err = bound_computation();
+	//exact rows for the counting tools
+	sc.exact = true;
+	mat_init(bools, nRows, vars, sc);
+	gauss_elimination(sc, true);
+	if (sc.matA.n_cols == 1) 
+		return interval_count(sc);
+	double err = bound_computation(sc);
 	
 	//bound checking
 	if (err < 0) {
@@ -856,25 +1429,24 @@ const double volce::solver::latte_core(int *bools, unsigned int nRows, std::vect
 	}
 	
 	//search previous counting result for reusing
-	std::vector<int> bools_vec;
-	if (enable_fact) {
-		for (unsigned int i = 0; i < nFormulas; i++) 
-			bools_vec.push_back(bools[i]);
-		std::map<std::vector<int>, double>::iterator vol_map_iter = vol_map.find(bools_vec);
-		if (vol_map_iter != vol_map.end()) {
-			//result exist
-			stats_vol_reuses++;
-			return vol_map_iter->second;
-		}
+	rational reuse;
+	if (vol_map_find(ENG_LATTE, sc, reuse)) {
+		//result exist
+		sc.stats_vol_reuses++;
+		return reuse;
 	}
 
 	//update stats of vol calls
-	stats_vol_calls++;
-	stats_total_dims += matA.n_cols;
-	if (matA.n_cols > stats_max_dims) stats_max_dims = matA.n_cols;
+	sc.stats_vol_calls++;
+	sc.stats_total_dims += sc.matA.n_cols;
+	if (sc.matA.n_cols > sc.stats_max_dims) sc.stats_max_dims = sc.matA.n_cols;
 	
 	//counting
-	std::string filename = tooldir + "/latte_input_tmp"; //.ine
+	//temp files go to the private dir of the worker
+	if (sc.workdir.empty() && !sc.make_workdir())
+		err_make_dir(workdir_root());
+	
+	std::string filename = sc.workdir + "/latte_input_tmp"; //.ine
 	
 	std::ofstream ofile;
 	
@@ -883,104 +1455,95 @@ const double volce::solver::latte_core(int *bools, unsigned int nRows, std::vect
 		err_open_file(filename);
 	}
 
-	//set printf format
-	ofile.setf(std::ios::fixed, std::ios::floatfield);
-	ofile.precision(0);
-
-	ofile << matA.n_rows << " " << matA.n_cols + 1 << std::endl;
+	ofile << sc.matA.n_rows << " " << sc.matA.n_cols + 1 << std::endl;
 	
-	for(unsigned int i = 0; i < matA.n_rows; i++) {
+	//exact integer rows, strict inequalities are tightened by 1
+	std::vector<rational> a;
+	rational b;
+	for(unsigned int i = 0; i < sc.matA.n_rows; i++) {
+	
+		integer_row(sc, i, a, b);
 
-		if (rowop[i] == 1){
+		if (sc.rowop[i] == 1){
 			//GT
-			ofile << (-1) * (colb[i] * 1000000 + 1)  << " ";
-			for (unsigned int j = 0; j < matA.n_cols; j++)
-				ofile << (-1) * matA(i, j) * 1000000 << " ";
+			ofile << -(b + 1) << " ";
+			for (unsigned int j = 0; j < sc.matA.n_cols; j++)
+				ofile << -a[j] << " ";
 			ofile << std::endl;
-		}else if (rowop[i] == -10){
+		}else if (sc.rowop[i] == -10){
 			//LE
-			ofile << colb[i] * 1000000 << " ";
-			for (unsigned int j = 0; j < matA.n_cols; j++)
-				ofile << matA(i, j) * 1000000 << " ";
+			ofile << b << " ";
+			for (unsigned int j = 0; j < sc.matA.n_cols; j++)
+				ofile << a[j] << " ";
 			ofile << std::endl;
-		}else if (rowop[i] == 10){
+		}else if (sc.rowop[i] == 10){
 			//GE
-			ofile << (-1) * colb[i] * 1000000 << " ";
-			for (unsigned int j = 0; j < matA.n_cols; j++)
-				ofile << (-1) * matA(i, j) * 1000000 << " ";
+			ofile << -b << " ";
+			for (unsigned int j = 0; j < sc.matA.n_cols; j++)
+				ofile << -a[j] << " ";
 			ofile << std::endl;
-		}else if (rowop[i] == -1){
+		}else if (sc.rowop[i] == -1){
 			//LT
-			ofile << colb[i] * 1000000 - 1 << " ";
-			for (unsigned int j = 0; j < matA.n_cols; j++)
-				ofile << matA(i, j) * 1000000 << " ";
+			ofile << b - 1 << " ";
+			for (unsigned int j = 0; j < sc.matA.n_cols; j++)
+				ofile << a[j] << " ";
 			ofile << std::endl;
 		} else {
 			//EQ = LE + GE
-			assert(rowop[i] != 0);
-/*			
-			ofile << colb[i] * 1000000 << " ";
-			for (unsigned int j = 0; j < matA.n_cols; j++)
-				ofile << matA(i, j) * 1000000 << " ";
-			ofile << std::endl;
-			ofile << (-1) * colb[i] * 1000000 << " ";
-			for (unsigned int j = 0; j < matA.n_cols; j++)
-				ofile << (-1) * matA(i, j) * 1000000 << " ";
-			ofile << std::endl;
-*/
+			assert(sc.rowop[i] != 0);
 		}
 	}
 	
 	ofile.close();
 
 	//execute latte
-	std::string cmd = "cd " + tooldir + "; ./count latte_input_tmp >/dev/null 2>/dev/null";
+	std::string cmd = "cd " + sc.workdir + "; " + tooldir + "/count latte_input_tmp >/dev/null 2>/dev/null";
+	//the output of the last call must not be read back if the tool fails
+	filename = sc.workdir + "/numOfLatticePoints";
+	unlink(filename.c_str());
 	int proc = system(cmd.c_str());
+	if (proc != 0) err_tool_failed("LattE");
 	
-	//read result
+	//read result, an integer of any length
 	std::ifstream ifile;
-	double count = 0;
-	filename = tooldir + "/numOfLatticePoints";
+	std::string text;
 
 	ifile.open(filename);
 	if (!ifile.is_open()) {
-		err_open_file(filename);
+		err_tool_failed("LattE");
 	}
 	
-	ifile >> count;
+	rational count;
+	if (!(ifile >> text) || !rational::parse(text, count)) err_tool_failed("LattE");
 	
 	ifile.close();
 
-	if (enable_fact) {
-		//new entry
-		vol_map.insert(std::pair<std::vector<int>, double>(bools_vec, count));
-	}
+	//new entry
+	vol_map_insert(ENG_LATTE, sc, count);
 	//std::cout << count << std::endl;
 	return count;
 }
 
-const double volce::solver::latte(int *boolsol){
+const volce::rational volce::solver::latte(const bsol &boolsol, const unsigned int nVars_comp, vol_scratch &sc){
 	std::vector<int> vars;
 	unsigned int nRows = 0;
-	double count = 1;
+	rational count = 1;
 	
 	// count rows
 	for (unsigned int i = 0; i < nFormulas; i++)
 		if (boolsol[i] >= 0)
 			nRows++;
 
-	if (nRows == 0) 
-		return 0;
 
 	unsigned int nVars_decided_total = get_decided_vars(boolsol, vars);
 
 	// no factorization
 	if (!enable_fact){
-		unsigned int nVars_undecided = nVars - nVars_decided_total;
+		unsigned int nVars_undecided = nVars_comp - nVars_decided_total;
 		//cout << "The number of decided variables: " << vars.size() << std::endl;
 		
 		//volume of cube consisted of undecided variables
-		double cube_count = pow(pow(2, wordlength), nVars_undecided);
+		rational cube_count = rational::pow2((unsigned long)wordlength * nVars_undecided);
 		if (wordlength == 0 && nVars_undecided > 0) {
 			//unbounded
 			err_unbounded_polytope();
@@ -989,57 +1552,55 @@ const double volce::solver::latte(int *boolsol){
 		if (nVars_decided_total == 0)
 			return cube_count;
 		else 
-			return latte_core(boolsol, nRows, vars) * cube_count;
+			return latte_core(boolsol, nRows, vars, sc) * cube_count;
 	}
 	
 	//factorization
-	std::vector<int*> pbools;
+	std::vector<bsol> pbools;
 	unsigned int nVars_tmp = 0;
 	unsigned int npbools = factorize_bsol(boolsol, pbools);
 	
 	//count the bunch factorized
-	if (npbools > 1) stats_fact_bunches++;
+	if (npbools > 1) sc.stats_fact_bunches++;
 	
 	//compute each subproblem
 	for (unsigned int i = 0; i < npbools; i++){
 		vars.clear();
-		nRows = 0;
-		for (unsigned int j = 0; j < nFormulas; j++){
-			if (pbools[i][j] < 0) continue;
-			nRows++;
-		}
+		nRows = pbools[i].count();
 	
 		unsigned int nVars_decided = get_decided_vars(pbools[i], vars);
 		nVars_tmp += nVars_decided;
 		
-		count *= latte_core(pbools[i], nRows, vars);
+		count *= latte_core(pbools[i], nRows, vars, sc);
 		
 	}
 	
-	assert(nVars_decided_total <= nVars);
+	assert(nVars_decided_total <= nVars_comp);
 	assert(nVars_decided_total == nVars_tmp);
 	
-	if (wordlength == 0 && nVars - nVars_decided_total > 0) {
+	if (wordlength == 0 && nVars_comp - nVars_decided_total > 0) {
 		//unbounded
 		err_unbounded_polytope();
 	}
 	
 	if (nVars_decided_total == 0)
-		return pow(pow(2, wordlength), nVars);
+		return rational::pow2((unsigned long)wordlength * nVars_comp);
 	else
-		return count * pow(pow(2, wordlength), nVars - nVars_decided_total);
+		return count * rational::pow2((unsigned long)wordlength * (nVars_comp - nVars_decided_total));
 }
 
-const double volce::solver::barvinok_core(int *bools, unsigned int nRows, std::vector<int> vars){
+const volce::rational volce::solver::barvinok_core(const bsol &bools, unsigned int nRows, std::vector<int> vars, vol_scratch &sc){
 	//nVars: the number of "decided" numeric variables
 	//nRows: the number of "decided" linear formulas
 	//nFormulas: the number of linear formulas
 	//bools[nFormulas], vars[nVars]
-	mat_init(bools, nRows, vars);
-	gauss_elimination();
-	if (matA.n_cols == 1) 
-		return interval_count();
-	double err = bound_computation();
+	//exact rows for the counting tools
+	sc.exact = true;
+	mat_init(bools, nRows, vars, sc);
+	gauss_elimination(sc, true);
+	if (sc.matA.n_cols == 1) 
+		return interval_count(sc);
+	double err = bound_computation(sc);
 	
 	//bound checking
 	if (err < 0) {
@@ -1047,25 +1608,24 @@ const double volce::solver::barvinok_core(int *bools, unsigned int nRows, std::v
 	}
 	
 	//search previous counting result for reusing
-	std::vector<int> bools_vec;
-	if (enable_fact) {
-		for (unsigned int i = 0; i < nFormulas; i++) 
-			bools_vec.push_back(bools[i]);
-		std::map<std::vector<int>, double>::iterator vol_map_iter = vol_map.find(bools_vec);
-		if (vol_map_iter != vol_map.end()) {
-			//result exist
-			stats_vol_reuses++;
-			return vol_map_iter->second;
-		}
+	rational reuse;
+	if (vol_map_find(ENG_BARVINOK, sc, reuse)) {
+		//result exist
+		sc.stats_vol_reuses++;
+		return reuse;
 	}
 
 	//update stats of vol calls
-	stats_vol_calls++;
-	stats_total_dims += matA.n_cols;
-	if (matA.n_cols > stats_max_dims) stats_max_dims = matA.n_cols;
+	sc.stats_vol_calls++;
+	sc.stats_total_dims += sc.matA.n_cols;
+	if (sc.matA.n_cols > sc.stats_max_dims) sc.stats_max_dims = sc.matA.n_cols;
 	
 	//counting
-	std::string filename = tooldir + "/barvinok_in.tmp";
+	//temp files go to the private dir of the worker
+	if (sc.workdir.empty() && !sc.make_workdir())
+		err_make_dir(workdir_root());
+	
+	std::string filename = sc.workdir + "/barvinok_in.tmp";
 	
 	std::ofstream ofile;
 	
@@ -1074,109 +1634,96 @@ const double volce::solver::barvinok_core(int *bools, unsigned int nRows, std::v
 		err_open_file(filename);
 	}
 
-	ofile << matA.n_rows << " " << matA.n_cols + 2 << std::endl;
+	ofile << sc.matA.n_rows << " " << sc.matA.n_cols + 2 << std::endl;
 
-	for(unsigned int i = 0; i < matA.n_rows; i++) {
+	//exact integer rows, strict inequalities are tightened by 1
+	std::vector<rational> a;
+	rational b;
+	for(unsigned int i = 0; i < sc.matA.n_rows; i++) {
 
 		//insert one row
-		double *a = new double[matA.n_cols];
-		double b = round(colb[i]);
-		
-		bool hasdecimal = (abs(1 - (double)b / colb[i]) > 0.001);
-		for (unsigned int j = 0; j < matA.n_cols; j++)
-		{
-			a[j] = round(matA(i, j));
-			if (abs(1 - (double)a[j] / matA(i, j)) > 0.001)
-				hasdecimal = true;
-		}
-		if (hasdecimal)
-		{
-			b *= 1000;
-			for (unsigned int j = 0; j < matA.n_cols; j++)
-				a[j] *= 1000;
-		}
+		integer_row(sc, i, a, b);
 
-		ofile << std::setprecision(0) << std::fixed;
-		if (rowop[i] == 1){
+		if (sc.rowop[i] == 1){
 			//GT
 			ofile << "1 ";
-			for (unsigned int j = 0; j < matA.n_cols; j++)
-				ofile << (-1) * a[j] << " ";
-			ofile << (-1) * (b + 1) << std::endl;
-		}else if (rowop[i] == -10){
+			for (unsigned int j = 0; j < sc.matA.n_cols; j++)
+				ofile << -a[j] << " ";
+			ofile << -(b + 1) << std::endl;
+		}else if (sc.rowop[i] == -10){
 			//LE
 			ofile << "1 ";
-			for (unsigned int j = 0; j < matA.n_cols; j++)
+			for (unsigned int j = 0; j < sc.matA.n_cols; j++)
 				ofile << a[j] << " ";
 			ofile << b << std::endl;
-		}else if (rowop[i] == 10){
+		}else if (sc.rowop[i] == 10){
 			//GE
 			ofile << "1 ";
-			for (unsigned int j = 0; j < matA.n_cols; j++)
-				ofile << (-1) * a[j] << " ";
-			ofile << (-1) * b  << std::endl;
-		}else if (rowop[i] == -1){
+			for (unsigned int j = 0; j < sc.matA.n_cols; j++)
+				ofile << -a[j] << " ";
+			ofile << -b  << std::endl;
+		}else if (sc.rowop[i] == -1){
 			//LT
 			ofile << "1 ";
-			for (unsigned int j = 0; j < matA.n_cols; j++)
+			for (unsigned int j = 0; j < sc.matA.n_cols; j++)
 				ofile << a[j] << " ";
 			ofile << b - 1 << std::endl;
 		} else {
 			//EQ = LE + GE
-			assert(rowop[i] != 0);
+			assert(sc.rowop[i] != 0);
 		}
 	}
 	
 	ofile.close();
 
 	//execute latte
-	std::string cmd = "cd " + tooldir + "; ./barvinok_count < barvinok_in.tmp";
+	std::string cmd = "cd " + sc.workdir + "; " + tooldir + "/barvinok_count < barvinok_in.tmp";
+	//the output of the last call must not be read back if the tool fails
+	filename = sc.workdir + "/tmp.out";
+	unlink(filename.c_str());
 	int proc = system(cmd.c_str());
+	if (proc != 0) err_tool_failed("Barvinok");
 	
-	//read result
+	//read result, an integer of any length
 	std::ifstream ifile;
-	double count = 0;
-	filename = tooldir + "/tmp.out";
+	std::string text;
 
 	ifile.open(filename);
 	if (!ifile.is_open()) {
-		err_open_file(filename);
+		err_tool_failed("Barvinok");
 	}
 	
-	ifile >> count;
+	rational count;
+	if (!(ifile >> text) || !rational::parse(text, count)) err_tool_failed("Barvinok");
 	
 	ifile.close();
 	
-	if (enable_fact) {
-		//new entry
-		vol_map.insert(std::pair<std::vector<int>, double>(bools_vec, count));
-	}
+	//new entry
+	vol_map_insert(ENG_BARVINOK, sc, count);
 	
 	return count;
 }
 
-const double volce::solver::barvinok(int *boolsol){
+const volce::rational volce::solver::barvinok(const bsol &boolsol, const unsigned int nVars_comp, vol_scratch &sc){
 	std::vector<int> vars;
 	unsigned int nRows = 0;
-	double count = 1;
+	rational count = 1;
 	
 	// count rows
 	for (unsigned int i = 0; i < nFormulas; i++)
 		if (boolsol[i] >= 0)
 			nRows++;
 
-	if (nRows == 0) 
-		return 0;
 
 	unsigned int nVars_decided_total = get_decided_vars(boolsol, vars);
 
 	// no factorization
 	if (!enable_fact){
-		unsigned int nVars_undecided = nVars - nVars_decided_total;
+		unsigned int nVars_undecided = nVars_comp - nVars_decided_total;
 		//cout << "The number of decided variables: " << vars.size() << std::endl;
 		
 		//volume of cube consisted of undecided variables
-		double cube_count = pow(pow(2, wordlength), nVars_undecided);
+		rational cube_count = rational::pow2((unsigned long)wordlength * nVars_undecided);
 		if (wordlength == 0 && nVars_undecided > 0) {
 			//unbounded
 			err_unbounded_polytope();
@@ -1185,62 +1732,59 @@ const double volce::solver::barvinok(int *boolsol){
 		if (nVars_decided_total == 0)
 			return cube_count;
 		else 
-			return barvinok_core(boolsol, nRows, vars) * cube_count;
+			return barvinok_core(boolsol, nRows, vars, sc) * cube_count;
 	}
 	
 	//factorization
-	std::vector<int*> pbools;
+	std::vector<bsol> pbools;
 	unsigned int nVars_tmp = 0;
 	unsigned int npbools = factorize_bsol(boolsol, pbools);
 	
 	//count the bunch factorized
-	if (npbools > 1) stats_fact_bunches++;
+	if (npbools > 1) sc.stats_fact_bunches++;
 	
 	//compute each subproblem
 	for (unsigned int i = 0; i < npbools; i++){
 		vars.clear();
-		nRows = 0;
-		for (unsigned int j = 0; j < nFormulas; j++){
-			if (pbools[i][j] < 0) continue;
-			nRows++;
-		}
+		nRows = pbools[i].count();
 	
 		unsigned int nVars_decided = get_decided_vars(pbools[i], vars);
 		nVars_tmp += nVars_decided;
 		
-		count *= barvinok_core(pbools[i], nRows, vars);
+		count *= barvinok_core(pbools[i], nRows, vars, sc);
 		
 	}
 	
-	assert(nVars_decided_total <= nVars);
+	assert(nVars_decided_total <= nVars_comp);
 	assert(nVars_decided_total == nVars_tmp);
 	
-	if (wordlength == 0 && nVars - nVars_decided_total > 0) {
+	if (wordlength == 0 && nVars_comp - nVars_decided_total > 0) {
 		//unbounded
 		err_unbounded_polytope();
 	}
 	
 	if (nVars_decided_total == 0)
-		return pow(pow(2, wordlength), nVars);
+		return rational::pow2((unsigned long)wordlength * nVars_comp);
 	else
-		return count * pow(pow(2, wordlength), nVars - nVars_decided_total);
+		return count * rational::pow2((unsigned long)wordlength * (nVars_comp - nVars_decided_total));
 }
 
 
 //////////////////////////////////////////////////////////////////////
 //// Approx Lattice Counting /////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////
-const double volce::solver::alc_core(int *bools, unsigned int nRows, std::vector<int> vars){
+const double volce::solver::alc_core(const bsol &bools, unsigned int nRows, std::vector<int> vars, vol_scratch &sc){
 	//nVars: the number of "decided" numeric variables
 	//nRows: the number of "decided" linear formulas
 	//nFormulas: the number of linear formulas
 	//bools[nFormulas], vars[nVars]
-	
-	mat_init(bools, nRows, vars);
-	gauss_elimination();
-	if (matA.n_cols == 1)
-		return interval_count();
-	double err = bound_computation();
+	//the approximate count runs on doubles
+	sc.exact = false;
+	mat_init(bools, nRows, vars, sc);
+	gauss_elimination(sc, false);
+	if (sc.matA.n_cols == 1)
+		return interval_count(sc).get_d();
+	double err = bound_computation(sc);
 	
 	//bound checking
 	if (err < 0) {
@@ -1248,23 +1792,24 @@ const double volce::solver::alc_core(int *bools, unsigned int nRows, std::vector
 	}
 	
 	//search previous counting result for reusing
-	std::vector<int> bools_vec;
-	for (unsigned int i = 0; i < nFormulas; i++) 
-		bools_vec.push_back(bools[i]);
-	std::map<std::vector<int>, double>::iterator vol_map_iter = vol_map.find(bools_vec);
-	if (vol_map_iter != vol_map.end()) {
+	double reuse;
+	if (vol_map_find(ENG_ALC, sc, reuse)) {
 		//result exist
-		stats_vol_reuses++;
-		return vol_map_iter->second;
+		sc.stats_vol_reuses++;
+		return reuse;
 	}
 
 	//update stats of vol calls
-	stats_vol_calls++;
-	stats_total_dims += matA.n_cols;
-	if (matA.n_cols > stats_max_dims) stats_max_dims = matA.n_cols;
+	sc.stats_vol_calls++;
+	sc.stats_total_dims += sc.matA.n_cols;
+	if (sc.matA.n_cols > sc.stats_max_dims) sc.stats_max_dims = sc.matA.n_cols;
 	
 	//counting
-	std::string filename = tooldir + "/alc_in.tmp";
+	//temp files go to the private dir of the worker
+	if (sc.workdir.empty() && !sc.make_workdir())
+		err_make_dir(workdir_root());
+	
+	std::string filename = sc.workdir + "/alc_in.tmp";
 	
 	std::ofstream ofile;
 	
@@ -1273,86 +1818,87 @@ const double volce::solver::alc_core(int *bools, unsigned int nRows, std::vector
 		err_open_file(filename);
 	}
 
-	ofile << matA.n_rows << " " << matA.n_cols + 2 << std::endl;
+	ofile << sc.matA.n_rows << " " << sc.matA.n_cols + 2 << std::endl;
 
-	for(unsigned int i = 0; i < matA.n_rows; i++) {
+	for(unsigned int i = 0; i < sc.matA.n_rows; i++) {
 	
 		ofile << std::setprecision(0) << std::fixed;
-		if (rowop[i] == 1){
+		if (sc.rowop[i] == 1){
 			//GT
 			ofile << "1 ";
-			for (unsigned int j = 0; j < matA.n_cols; j++)
-				ofile << (-1) * matA(i, j) << " ";
-			ofile << (-1) * (colb[i] + 1) << std::endl;
-		}else if (rowop[i] == -10){
+			for (unsigned int j = 0; j < sc.matA.n_cols; j++)
+				ofile << (-1) * sc.matA(i, j) << " ";
+			ofile << (-1) * (sc.colb[i] + 1) << std::endl;
+		}else if (sc.rowop[i] == -10){
 			//LE
 			ofile << "1 ";
-			for (unsigned int j = 0; j < matA.n_cols; j++)
-				ofile << matA(i, j) << " ";
-			ofile << colb[i] << std::endl;
-		}else if (rowop[i] == 10){
+			for (unsigned int j = 0; j < sc.matA.n_cols; j++)
+				ofile << sc.matA(i, j) << " ";
+			ofile << sc.colb[i] << std::endl;
+		}else if (sc.rowop[i] == 10){
 			//GE
 			ofile << "1 ";
-			for (unsigned int j = 0; j < matA.n_cols; j++)
-				ofile << (-1) * matA(i, j) << " ";
-			ofile << (-1) * colb[i]  << std::endl;
-		}else if (rowop[i] == -1){
+			for (unsigned int j = 0; j < sc.matA.n_cols; j++)
+				ofile << (-1) * sc.matA(i, j) << " ";
+			ofile << (-1) * sc.colb[i]  << std::endl;
+		}else if (sc.rowop[i] == -1){
 			//LT
 			ofile << "1 ";
-			for (unsigned int j = 0; j < matA.n_cols; j++)
-				ofile << matA(i, j) << " ";
-			ofile << colb[i] - 1 << std::endl;
+			for (unsigned int j = 0; j < sc.matA.n_cols; j++)
+				ofile << sc.matA(i, j) << " ";
+			ofile << sc.colb[i] - 1 << std::endl;
 		} else {
 			//EQ = LE + GE
-			assert(rowop[i] != 0);
+			assert(sc.rowop[i] != 0);
 		}
 	}
 	
 	ofile.close();
 
 	//execute latte
-	std::string cmd = "cd " + tooldir + "; ./ApproxLatCount alc_in.tmp >/dev/null 2>/dev/null";
+	std::string cmd = "cd " + sc.workdir + "; " + tooldir + "/ApproxLatCount alc_in.tmp >/dev/null 2>/dev/null";
+	//the output of the last call must not be read back if the tool fails
+	filename = sc.workdir + "/tmp.out";
+	unlink(filename.c_str());
 	int proc = system(cmd.c_str());
+	if (proc != 0) err_tool_failed("ALC");
 	
 	//read result
 	std::ifstream ifile;
 	double count = 0;
-	filename = tooldir + "/tmp.out";
 
 	ifile.open(filename);
 	if (!ifile.is_open()) {
-		err_open_file(filename);
+		err_tool_failed("ALC");
 	}
 	
-	ifile >> count;
+	if (!(ifile >> count)) err_tool_failed("ALC");
 	
 	ifile.close();
 	
 	//new entry
-	vol_map.insert(std::pair<std::vector<int>, double>(bools_vec, count));
+	vol_map_insert(ENG_ALC, sc, count);
 	
 	return count;
 }
 
-const double volce::solver::alc(int *boolsol){
+const volce::bigvol volce::solver::alc(const bsol &boolsol, const unsigned int nVars_comp, vol_scratch &sc){
 	std::vector<int> vars;
 	unsigned int nRows = 0;
-	double count = 1;
+	bigvol count = 1;
 	
 	for (unsigned int i = 0; i < nFormulas; i++){
 		if (boolsol[i] < 0) continue;
 		nRows++;
 	}
-	if (nRows == 0) return 0;
-
 	unsigned int nVars_decided_total = get_decided_vars(boolsol, vars);
 
 	if (!enable_fact){
-		unsigned int nVars_undecided = nVars - nVars_decided_total;
+		unsigned int nVars_undecided = nVars_comp - nVars_decided_total;
 		//cout << "The number of decided variables: " << vars.size() << std::endl;
 		
 		//volume of cube consisted of undecided variables
-		double cube_count = pow(pow(2, wordlength), nVars_undecided);
+		bigvol cube_count = bigvol::pow2((long)wordlength * nVars_undecided);
 		if (wordlength == 0 && nVars_undecided > 0) {
 			//unbounded
 			err_unbounded_polytope();
@@ -1361,63 +1907,61 @@ const double volce::solver::alc(int *boolsol){
 		if (nVars_decided_total == 0)
 			return cube_count;
 		else
-			return alc_core(boolsol, nRows, vars) * cube_count;
+			return bigvol(alc_core(boolsol, nRows, vars, sc)) * cube_count;
 	}
 	
 	//factorization
-	std::vector<int*> pbools;
+	std::vector<bsol> pbools;
 	unsigned int nVars_tmp = 0;
 	unsigned int npbools = factorize_bsol(boolsol, pbools);
 	
 	//count the bunch factorized
-	if (npbools > 1) stats_fact_bunches++;
+	if (npbools > 1) sc.stats_fact_bunches++;
 	
 	//compute each subproblem
 	for (unsigned int i = 0; i < npbools; i++){
 		vars.clear();
-		nRows = 0;
-		for (unsigned int j = 0; j < nFormulas; j++){
-			if (pbools[i][j] < 0) continue;
-			nRows++;
-		}
+		nRows = pbools[i].count();
 	
 		unsigned int nVars_decided = get_decided_vars(pbools[i], vars);
 		nVars_tmp += nVars_decided;
 		
-		count *= alc_core(pbools[i], nRows, vars);
+		count *= bigvol(alc_core(pbools[i], nRows, vars, sc));
 		
 	}
 	
-	assert(nVars_decided_total <= nVars);
+	assert(nVars_decided_total <= nVars_comp);
 	assert(nVars_decided_total == nVars_tmp);
 	
-	if (wordlength == 0 && nVars - nVars_decided_total > 0) {
+	if (wordlength == 0 && nVars_comp - nVars_decided_total > 0) {
 		//unbounded
 		err_unbounded_polytope();
 	}
 	
 	if (nVars_decided_total == 0)
-		return pow(pow(2, wordlength), nVars);
+		return bigvol::pow2((long)wordlength * nVars_comp);
 	else
-		return count * pow(pow(2, wordlength), nVars - nVars_decided_total);
+		return count * bigvol::pow2((long)wordlength * (nVars_comp - nVars_decided_total));
 }
 
 ///////////////////////////////////
 //// V2L //////////////////////////
 ///////////////////////////////////
-const volce::VOL_RES_CLS volce::solver::v2l_core(int *bools, unsigned int nRows, std::vector<int> vars){
+const volce::VOL_RES_CLS volce::solver::v2l_core(const bsol &bools, unsigned int nRows, std::vector<int> vars, vol_scratch &sc){
 	//nVars: the number of "decided" numeric variables
 	//nRows: the number of "decided" linear formulas
 	//nFormulas: the number of linear formulas
 	//bools[nFormulas], vars[nVars]
-	mat_init(bools, nRows, vars);
-	unsigned int nelim = gauss_elimination();
-	if (matA.n_cols == 1)
+	//the approximation runs on doubles
+	sc.exact = false;
+	mat_init(bools, nRows, vars, sc);
+	unsigned int nelim = gauss_elimination(sc, false);
+	if (sc.matA.n_cols == 1)
 	{
-		double lat = interval_count();
+		double lat = interval_count(sc).get_d();
 		return VOL_RES_CLS(lat, lat, lat);
 	}
-	double err = bound_computation();
+	double err = bound_computation(sc);
 	
 	//bound checking
 	if (err < 0) {
@@ -1425,98 +1969,28 @@ const volce::VOL_RES_CLS volce::solver::v2l_core(int *bools, unsigned int nRows,
 	}
 	
 	//search previous computation result for reusing
-	std::vector<int> bools_vec;
-	if (enable_fact) {
-		for (unsigned int i = 0; i < nFormulas; i++) 
-			bools_vec.push_back(bools[i]);
-		std::map<std::vector<int>, double>::iterator vol_map_iter = vol_map.find(bools_vec);
-		if (vol_map_iter != vol_map.end()) {
-			//result exist
-			stats_vol_reuses++;
-			return VOL_RES_CLS(vol_map_iter->second, vol_map_iter->second + err, vol_map_iter->second - err);
-		}
+	double reuse;
+	if (vol_map_find(ENG_V2L, sc, reuse)) {
+		//result exist
+		sc.stats_vol_reuses++;
+		return VOL_RES_CLS(reuse, reuse + err, reuse - err);
 	}
 	
 	//update stats of vol calls
-	stats_vol_calls++;
-	stats_total_dims += matA.n_cols;
-	if (matA.n_cols > stats_max_dims) stats_max_dims = matA.n_cols;
+	sc.stats_vol_calls++;
+	sc.stats_total_dims += sc.matA.n_cols;
+	if (sc.matA.n_cols > sc.stats_max_dims) sc.stats_max_dims = sc.matA.n_cols;
 	
 	// compute
-	std::string filename = tooldir + "/vinci_input_tmp"; //.ine
-
-	std::ofstream ofile;
-	
-	ofile.open(filename + ".ine");
-	if (!ofile.is_open()) {
-		err_open_file(filename);
-	}
-
-	//set printf format
-	ofile.setf(std::ios::fixed, std::ios::floatfield);
-
-	ofile << "H-representation" << std::endl;
-	ofile << "begin" << std::endl;
-	ofile << matA.n_rows << " " << matA.n_cols + 1 << " real" << std::endl;
-	
-	for(unsigned int i = 0; i < matA.n_rows; i++) {
-
-		if (rowop[i] > 0) {
-			ofile << -colb[i] << " ";
-			for (unsigned int j = 0; j < matA.n_cols; j++)
-				ofile << matA(i, j) << " ";
-			ofile << std::endl;
-		} else if (rowop[i] < 0) {
-			ofile << colb[i] << " ";
-			for (unsigned int j = 0; j < matA.n_cols; j++)
-				ofile << -matA(i, j) << " ";
-			ofile << std::endl;
-		} else {
-			assert(rowop[i] != 0);
-/*
-			ofile << -colb[i] << " ";
-			for (unsigned int j = 0; j < matA.n_cols; j++)
-				ofile << matA(i, j) << " ";
-			ofile << std::endl;
-			ofile << colb[i] << " ";
-			for (unsigned int j = 0; j < matA.n_cols; j++)
-				ofile << -matA(i, j) << " ";
-			ofile << std::endl;
-*/
-		}
-	}
-	
-	ofile << "end" << std::endl;
+	double vol = vinci_compute(sc.matA, sc.colb, sc.rowop.data());
 	
-	ofile.close();
-	
-	//execute vinci
-	std::string cmd = "cd " + tooldir + "; ./vinci vinci_input_tmp >/dev/null";
-	int proc = system(cmd.c_str());
-	
-	//read result
-	std::ifstream ifile;
-	double vol = 0;
-	filename = tooldir + "/vinci.result";
-
-	ifile.open(filename);
-	if (!ifile.is_open()) {
-		err_open_file(filename);
-	}
-	
-	ifile >> vol;
-	
-	ifile.close();	
-	
-	if (enable_fact) {
-		//new entry
-		vol_map.insert(std::pair<std::vector<int>, double>(bools_vec, vol));
-	}
+	//new entry
+	vol_map_insert(ENG_V2L, sc, vol);
 	return VOL_RES_CLS(vol, vol + err, vol - err);
 	
 }
 
-const volce::VOL_RES_CLS volce::solver::v2l(int *boolsol){
+const volce::VOL_RES_CLS volce::solver::v2l(const bsol &boolsol, const unsigned int nVars_comp, vol_scratch &sc){
 
 	std::vector<int> vars;
 	unsigned int nRows = 0;
@@ -1527,17 +2001,15 @@ const volce::VOL_RES_CLS volce::solver::v2l(int *boolsol){
 		if (boolsol[i] >= 0) 
 			nRows++;
 
-	if (nRows == 0)
-		return VOL_RES_CLS(0, 0, 0);
 	
 	unsigned int nVars_decided_total = get_decided_vars(boolsol, vars);
 	
 	// no factorization
 	if (!enable_fact){
-		unsigned int nVars_undecided = nVars - nVars_decided_total;
+		unsigned int nVars_undecided = nVars_comp - nVars_decided_total;
 		
 		//volume of cube consisted of undecided variables
-		double cube_vol = pow(pow(2, wordlength), nVars_undecided);
+		bigvol cube_vol = bigvol::pow2((long)wordlength * nVars_undecided);
 		if (wordlength == 0 && nVars_undecided > 0) {
 			//unbounded
 			err_unbounded_polytope();
@@ -1546,44 +2018,40 @@ const volce::VOL_RES_CLS volce::solver::v2l(int *boolsol){
 		if (nVars_decided_total == 0)
 			return VOL_RES_CLS(cube_vol, cube_vol, cube_vol);
 		else
-			return v2l_core(boolsol, nRows, vars) * cube_vol;
+			return v2l_core(boolsol, nRows, vars, sc) * cube_vol;
 	}
 	
 	//factorization
-	std::vector<int*> pbools;
+	std::vector<bsol> pbools;
 	unsigned int nVars_tmp = 0;
 	unsigned int npbools = factorize_bsol(boolsol, pbools);
 	
 	//count the bunch factorized
-	if (npbools > 1) stats_fact_bunches++;
+	if (npbools > 1) sc.stats_fact_bunches++;
 	
 	//compute each subproblem
 	for (unsigned int i = 0; i < npbools; i++){
 		vars.clear();
-		nRows = 0;
-		for (unsigned int j = 0; j < nFormulas; j++){
-			if (pbools[i][j] < 0) continue;
-			nRows++;
-		}
+		nRows = pbools[i].count();
 	
 		unsigned int nVars_decided = get_decided_vars(pbools[i], vars);
 		nVars_tmp += nVars_decided;
 		
-		vol = vol * v2l_core(pbools[i], nRows, vars);
+		vol = vol * v2l_core(pbools[i], nRows, vars, sc);
 	}
 	
-	assert(nVars_decided_total <= nVars);
+	assert(nVars_decided_total <= nVars_comp);
 	assert(nVars_decided_total == nVars_tmp);
 	
-	if (wordlength == 0 && nVars - nVars_decided_total > 0) {
+	if (wordlength == 0 && nVars_comp - nVars_decided_total > 0) {
 		//unbounded
 		err_unbounded_polytope();
 	}
 	
 	if (nVars_decided_total == 0) {
-		double v = pow(pow(2, wordlength), nVars);
+		bigvol v = bigvol::pow2((long)wordlength * nVars_comp);
 		return VOL_RES_CLS(v, v, v);
 	} else
-		return vol * pow(pow(2, wordlength), nVars - nVars_decided_total);
+		return vol * bigvol::pow2((long)wordlength * (nVars_comp - nVars_decided_total));
 }
 
@@ -0,0 +1,10 @@
+(set-logic QF_LIA)
+(set-info :source | Gauss elimination must not substitute y by (4 - x) / 2 when counting integer points. The counts of LattE and Barvinok are 3, the points (0, 2), (2, 1) and (4, 0). |)
+(set-info :status sat)
+(declare-fun x () Int)
+(declare-fun y () Int)
+(assert (and (>= x 0) (<= x 4)))
+(assert (and (>= y 0) (<= y 4)))
+(assert (= (+ x (* 2 y)) 4))
+(check-sat)
+(exit)
@@ -0,0 +1,12 @@
+(set-logic QF_LIA)
+(set-info :source | The approximate engines eliminate z by partial pivoting, although no variable has a unit coefficient. With -v2l, the volume (Vinci) of the projection onto x and y is 12, the triangle 2x + 3y <= 12, not 0 of a flat polytope. ALC walks in the same full-dimensional triangle. The exact count is 7. |)
+(set-info :status sat)
+(declare-fun x () Int)
+(declare-fun y () Int)
+(declare-fun z () Int)
+(assert (and (>= x 0) (<= x 6)))
+(assert (and (>= y 0) (<= y 6)))
+(assert (and (>= z 0) (<= z 6)))
+(assert (= (+ (* 2 x) (* 3 y) (* 4 z)) 12))
+(check-sat)
+(exit)
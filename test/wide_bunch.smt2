@@ -0,0 +1,82 @@
+(set-logic QF_LRA)
+(set-info :source | bunches of more than 64 literals, which span two words of bsol. With -v -w=3, the total volume (Vinci) is 1.21533e+15, and Z3 4.8.12 gives 148 bunches. A miscounted conflict with previous bunches gives more bunches. |)
+(set-info :status sat)
+(declare-fun b0 () Bool)
+(declare-fun b1 () Bool)
+(declare-fun b2 () Bool)
+(declare-fun b3 () Bool)
+(declare-fun b4 () Bool)
+(declare-fun b5 () Bool)
+(declare-fun b6 () Bool)
+(declare-fun b7 () Bool)
+(declare-fun b8 () Bool)
+(declare-fun b9 () Bool)
+(declare-fun b10 () Bool)
+(declare-fun b11 () Bool)
+(declare-fun b12 () Bool)
+(declare-fun b13 () Bool)
+(declare-fun b14 () Bool)
+(declare-fun b15 () Bool)
+(declare-fun b16 () Bool)
+(declare-fun b17 () Bool)
+(declare-fun b18 () Bool)
+(declare-fun b19 () Bool)
+(declare-fun b20 () Bool)
+(declare-fun b21 () Bool)
+(declare-fun b22 () Bool)
+(declare-fun b23 () Bool)
+(declare-fun b24 () Bool)
+(declare-fun b25 () Bool)
+(declare-fun b26 () Bool)
+(declare-fun b27 () Bool)
+(declare-fun b28 () Bool)
+(declare-fun b29 () Bool)
+(declare-fun b30 () Bool)
+(declare-fun b31 () Bool)
+(declare-fun b32 () Bool)
+(declare-fun b33 () Bool)
+(declare-fun b34 () Bool)
+(declare-fun b35 () Bool)
+(declare-fun b36 () Bool)
+(declare-fun b37 () Bool)
+(declare-fun b38 () Bool)
+(declare-fun b39 () Bool)
+(declare-fun b40 () Bool)
+(declare-fun b41 () Bool)
+(declare-fun b42 () Bool)
+(declare-fun b43 () Bool)
+(declare-fun b44 () Bool)
+(declare-fun b45 () Bool)
+(declare-fun b46 () Bool)
+(declare-fun b47 () Bool)
+(declare-fun b48 () Bool)
+(declare-fun b49 () Bool)
+(declare-fun b50 () Bool)
+(declare-fun b51 () Bool)
+(declare-fun b52 () Bool)
+(declare-fun b53 () Bool)
+(declare-fun b54 () Bool)
+(declare-fun b55 () Bool)
+(declare-fun b56 () Bool)
+(declare-fun b57 () Bool)
+(declare-fun b58 () Bool)
+(declare-fun b59 () Bool)
+(declare-fun x0 () Real)
+(declare-fun x1 () Real)
+(assert (<= x0 4))
+(assert (>= x0 (- 4)))
+(assert (<= x1 4))
+(assert (>= x1 (- 4)))
+(assert (not b8))
+(assert (ite b9 b15 (not b14)))
+(assert (or (= (= (< (+ (* 1 x0) (* 1 x1)) 0) (< (+ (* (- 2) x0) (* (- 2) x1)) 0)) (ite (not b56) (not b19) b12)) b20))
+(assert (not (> (+ (* 0 x0) (* 1 x1)) 1)))
+(assert b55)
+(assert (not (or (ite b23 (not b43) b18) (not b30))))
+(assert (ite (ite (and (not b36) (< (+ (* 1 x0) (* (- 3) x1)) 0) (not b47)) (not b52) b43) (<= (+ (* 0 x0) (* (- 3) x1)) 2) (= b2 (not b4))))
+(assert (> (+ (* 1 x0) (* (- 1) x1)) 3))
+(assert (not (or (= b13 (< (+ (* (- 1) x0) (* 2 x1)) 2)) (ite (< (+ (* (- 3) x0) (* 1 x1)) 1) b37 b23) (not (< (+ (* 0 x0) (* (- 1) x1)) 4)))))
+(assert (= (not b53) (not (not b16))))
+(assert (not (ite (not (<= (+ (* (- 1) x0) (* (- 2) x1)) 0)) (or b17 b41) (ite (not b46) (<= (+ (* 1 x0) (* (- 2) x1)) 2) (> (+ (* (- 3) x0) (* (- 1) x1)) 0)))))
+(assert (or (= (or (>= (+ (* (- 3) x0) (* (- 2) x1)) 1) (not b12)) (and (not b16) (not b41) (< (+ (* 0 x0) (* (- 1) x1)) 4))) (not b3)))
+(check-sat)